@@ -1,71 +1,127 @@
 /**
  * @file board_available.cpp
- * @brief 4x4 Sliding Puzzle Available Moves Finder
- * 
-* This program analyzes a 4x4 sliding puzzle board configuration and determines
+ * @brief Sliding Puzzle Available Moves Finder
+ *
+* This program analyzes a sliding puzzle board configuration and determines
  * all valid moves that can be made from the current state.
+ *
+ * The legal moves come from the precomputed mask table of move_table.h. With
+ * --batch every input line is a board and the output has one line per board
+ * with its moves separated by spaces; boards are processed in blocks of
+ * BATCH_BOARDS through the batch form of the table. A line whose length is
+ * not a perfect square is reported on stderr and gets an empty output line,
+ * so output line i still belongs to input line i.
+ *
+ * Usage:
+ *      echo "ABCDEFGHIJKLMNO#" | ./board_available
+ *      ./board_available --batch < boards.txt
  */
 #include <iostream>
+#include <cmath>
+#include <cstdio>
+#include <memory>
 #include <string>
 #include <vector>
+#include "move_table.h"
 
 using namespace std;
 
+const char* const MOVE_NAMES[] = {"UP", "DOWN", "LEFT", "RIGHT"};
+const size_t BATCH_BOARDS = 4096;
+
+/**
+ * @brief Appends the names of the moves set in `mask`, separated by `separator`
+ */
+void appendMoves(string& out, uint8_t mask, char separator){
+  bool first = true;
+  for (int move = 0; move < 4; move++){
+    if (!(mask & (1 << move))) continue;
+    if (!first) out += separator;
+    out += MOVE_NAMES[move];
+    first = false;
+  }
+}
+
+/**
+ * @brief Side of a square board, or 0 when the length is not a perfect square
+ */
+int boardSide(const string &board){
+  int side = (int)lround(sqrt((double)board.size()));
+  if ((size_t)side * side != board.size()){
+    cerr << "Tablero no válido " << board << ": la longitud no es un cuadrado perfecto" << endl;
+    return 0;
+  }
+  return side;
+}
+
 /**
  * @brief Finds and displays all available moves for the current board state
  *
  */
-void listAvailable(vector<vector<char>> &board){
-  int posx = -1;
-  int posy = -1;
-  vector<string> moves = {"UP", "DOWN", "LEFT", "RIGHT"};
-  for (int i = 0; i < 4; i++){
-    for (int j = 0; j < 4; j++){
-      if (board[i][j] == '#'){
-        posx = i;
-        posy = j; 
-        break;
-      }
-    }
-    if (posx > 0 && posy > 0){
-      break;
+void listAvailable(const string &board){
+  int side = boardSide(board);
+  if (side == 0) return;
+  size_t blank = board.find('#');
+  if (blank == string::npos) return;
+  string out;
+  appendMoves(out, MoveTable(side).mask((int)blank), '\n');
+  cout << out << endl;
+}
+
+/**
+ * @brief Prints the moves of every board read from standard input, one line per board
+ */
+void listAvailableBatch(){
+  string board, out;
+  vector<char> boards;
+  vector<uint8_t> masks(BATCH_BOARDS);
+  unique_ptr<MoveTable> table;
+  size_t pending = 0;
+
+  auto flushBlock = [&](){
+    if (pending == 0) return;
+    table->masks((const char*)boards.data(), pending, masks.data());
+    for (size_t i = 0; i < pending; i++){
+      appendMoves(out, masks[i], ' ');
+      out += '\n';
     }
-  }
-  if (posx == 0){
-    moves.erase(moves.begin());
-  }
-  else if (posx == 3){
-    moves.erase(moves.begin() + 1);
-  }
-  if (posy == 0){
-    moves.erase(moves.begin() + 2);
-  }
-  else if (posy == 3){
-    moves.erase(moves.begin() + 3);
-  }
+    fwrite(out.data(), 1, out.size(), stdout);
+    out.clear();
+    boards.clear();
+    pending = 0;
+  };
 
-  for(int i = 0; i < moves.size(); i++){
-    cout << moves[i] << endl;
+  while (cin >> board){
+    int side = boardSide(board);
+    if (side == 0){
+      flushBlock();
+      fputs("\n", stdout);
+      continue;
+    }
+    if (!table || table->side() != side){
+      flushBlock();
+      table.reset(new MoveTable(side));
+    }
+    for (char c : board) boards.push_back(c == '#' ? (char)BLANK_TILE : c);
+    if (++pending == BATCH_BOARDS) flushBlock();
   }
+  flushBlock();
 }
+
 /**
  * @brief Main function - program entry point
- * 
+ *
  * Reads the board configuration from standard input and displays all
  * available moves based on the empty space position.
  */
-int main(){
-      vector<vector<char>> board;
+int main(int argc, char* argv[]){
+      ios::sync_with_stdio(false);
+      if (argc > 1 && string(argv[1]) == "--batch"){
+            listAvailableBatch();
+            return 0;
+      }
       string in;
       cin >> in;
-      for (int r = 0; r < 4; ++r){
-            vector<char> row;
-            for (int i = 0; i < 4; i++)
-            {
-                  row.push_back(in[4 * r + i]);
-            }
-            board.push_back(row);
-      }
-      listAvailable(board);
+      listAvailable(in);
       return 0;
-}
\ No newline at end of file
+}
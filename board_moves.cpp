@@ -1,83 +1,174 @@
 /**
  * @file board_moves.cpp
- * @brief 4x4 Sliding Puzzle Move Simulator
+ * @brief Sliding Puzzle Move Simulator and bulk move-sequence validator
+ *
+ * Without arguments it reads a board and one move from standard input and
+ * prints the board after the move, as before:
+ *
+ *      echo "ABCDEFGHIJKLMNO# UP" | ./board_moves
+ *
+ * With --batch it replays whole sequences, one "<tablero> <movimientos>"
+ * pair per line, and prints one CSV record per line:
+ *
+ *      index,reached_goal,first_illegal,applied
+ *
+ * where index is the line number (from 1), first_illegal the position of the
+ * first move that leaves the board (-1 if none; the replay stops there) and
+ * applied the number of moves played. A line whose board or moves do not
+ * parse still gets its record, with first_illegal = INVALID_BOARD (-3, see
+ * result_writer.h), so every non-blank line has exactly one row. Sequences are compact ("UULDR") or
+ * named ("UP,UP,LEFT"), see move_replay.h. 4x4 boards are replayed packed in
+ * a uint64, larger ones in a flat tile array.
+ *
+ * Compilation:
+ *      g++ -std=c++17 -O2 -o board_moves board_moves.cpp
+ *
+ * Usage:
+ *      ./board_moves --batch [--input <archivo>] [--side <n>]
  */
 #include <iostream>
+#include <fstream>
+#include <cmath>
+#include <cstdio>
+#include <string>
 #include <vector>
+#include <algorithm>
+#include "puzzle_tiles.h"
+#include "move_replay.h"
+#include "result_writer.h"
 
 using namespace std;
 
 /**
- * @brief Prints a 4x4 board with proper formatting
+ * @brief Prints a side x side board with proper formatting
  */
-void print_board(vector<vector<char>> board){
-      for (int i = 0; i < 4; i++){
-            for (int j = 0; j < 4; j++){
-                  cout << board[i][j];
-                  if (j < 3) cout << " ";
+void print_board(const string& board, int side){
+      for (int i = 0; i < side; i++){
+            for (int j = 0; j < side; j++){
+                  cout << board[i * side + j];
+                  if (j < side - 1) cout << " ";
             }
-            if (i < 3) cout << endl;
+            if (i < side - 1) cout << endl;
       }
       cout << endl;
 }
+
 /**
  * @brief Executes a move on the puzzle board by sliding the empty space
- * 
- * Searches for the empty space ('#') and attempts to move it in the specified
- * direction by swapping with the adjacent tile. The move is only executed if
- * it remains within the board boundaries.
+ *
+ * The move is only executed if it remains within the board boundaries.
+ */
+void doMove(string &board, int side, const string& move){
+      int blank = (int)board.find('#');
+      int next = blank < 0 ? -1 : movedBlank(blank, parseMoveName(move), side);
+      if (next >= 0){
+            board[blank] = board[next];
+            board[next] = '#';
+      }
+      print_board(board, side);
+}
+
+/**
+ * @brief Board side deduced from the number of tiles in a text board
  */
-void doMove(vector<vector<char>> &board, string move){
-      for (int i = 0; i < 4; i++){
-        for (int j = 0; j < 4; j++){
-          if (board[i][j] == '#'){
-            if (move == "DOWN" && i < 3){
-              char temp = board[i + 1][j];
-              board[i][j] = temp;
-              board[i + 1][j] = '#';
-              break;
-            }else if (move == "UP" && i > 0){
-              char temp = board[i - 1][j];
-              board[i][j] = temp;
-              board[i - 1][j] = '#';
-              break;
-            }else if (move == "RIGHT" && j < 3){
-              char temp = board[i][j + 1];
-              board[i][j] = temp;
-              board[i][j + 1] = '#';
-              break;
-            }else if (move == "LEFT" && j > 0){
-              char temp = board[i][j - 1];
-              board[i][j] = temp;
-              board[i][j - 1] = '#';
-              break;
+int sideOf(const string& board){
+      size_t cells = board.find(',') == string::npos ? board.size() : count(board.begin(), board.end(), ',') + 1;
+      return (int)lround(sqrt((double)cells));
+}
+
+/**
+ * @brief Replays every "<tablero> <movimientos>" line of `in`
+ */
+int replayBatch(istream& in, int fixedSide){
+      string output = "index,reached_goal,first_illegal,applied\n";
+      string line, boardText, movesText, error;
+      vector<uint16_t> tiles, goal;
+      vector<int> moves;
+      MoveTable table(1);
+      int goalSide = 0;
+      uint64_t packedGoal = 0;
+      long long index = 0;
+      int invalid = 0;
+
+      while (getline(in, line)){
+            index++;
+            size_t boardStart = line.find_first_not_of(" \t\r");
+            if (boardStart == string::npos) continue;
+            size_t boardEnd = line.find_first_of(" \t\r", boardStart);
+            boardText.assign(line, boardStart, boardEnd == string::npos ? string::npos : boardEnd - boardStart);
+            size_t movesStart = boardEnd == string::npos ? string::npos : line.find_first_not_of(" \t\r", boardEnd);
+            if (movesStart == string::npos) movesText = "-";
+            else movesText.assign(line, movesStart, line.find_last_not_of(" \t\r") + 1 - movesStart);
+
+            int side = fixedSide > 0 ? fixedSide : sideOf(boardText);
+            if (!parseTiles(boardText, side, tiles, error) || !parseMoves(movesText, moves)){
+                  cerr << "Línea " << index << " no válida: " << (error.empty() ? "movimiento desconocido" : error) << endl;
+                  error.clear();
+                  invalid++;
+                  output += to_string(index) + ",0," + to_string(INVALID_BOARD) + ",0\n";
+                  continue;
+            }
+            if (side != goalSide){
+                  goalSide = side;
+                  goal = canonicalGoalTiles(side);
+                  table = MoveTable(side);
+                  if (side == 4) packedGoal = packBoard16(goal);
+            }
+
+            ReplayResult result;
+            if (side == 4){
+                  uint64_t packed = packBoard16(tiles);
+                  result = replayMovesPacked16(packed, table, moves, packedGoal);
+            } else {
+                  result = replayMoves(tiles, table, moves, goal);
+            }
+            output += to_string(index) + "," + (result.reachedGoal ? "1" : "0") + "," +
+                      to_string(result.firstIllegal) + "," + to_string(result.applied) + "\n";
+            if (output.size() >= (1 << 16)){
+                  fwrite(output.data(), 1, output.size(), stdout);
+                  output.clear();
             }
-          }
-        }
       }
-      print_board(board);
+      fwrite(output.data(), 1, output.size(), stdout);
+      return invalid == 0 ? 0 : 1;
 }
 
 /**
  * @brief Main function - program entry point
- * 
- * Reads input, initializes the board, and executes the requested move.
+ *
+ * Reads input, initializes the board, and executes the requested move, or
+ * replays a batch of sequences with --batch.
  */
-int main(){
-      vector<vector<char>> board;
-      string in;
-      string move;
-      cin >> in;
-      cin >> move;
+int main(int argc, char* argv[]){
+      ios::sync_with_stdio(false);
+      bool batch = false;
+      string inputPath;
+      int side = 0;
+      for (int i = 1; i < argc; i++){
+            string arg = argv[i];
+            if (arg == "--batch") batch = true;
+            else if (arg == "--input" && i + 1 < argc) inputPath = argv[++i];
+            else if (arg == "--side" && i + 1 < argc) side = stoi(argv[++i]);
+            else {
+                  cerr << "Uso: " << argv[0] << " [--batch [--input <archivo>] [--side <n>]]" << endl;
+                  return 1;
+            }
+      }
 
-      for (int r = 0; r < 4; ++r){
-            vector<char> row;
-            for (int i = 0; i < 4; i++)
-            {
-                  row.push_back(in[4 * r + i]);
+      if (batch){
+            if (inputPath.empty()) return replayBatch(cin, side);
+            ifstream infile(inputPath);
+            if (!infile){
+                  cerr << "Error: no se pudo abrir " << inputPath << endl;
+                  return 1;
             }
-            board.push_back(row);
+            return replayBatch(infile, side);
       }
-      doMove(board, move);
+
+      string board;
+      string move;
+      cin >> board;
+      cin >> move;
+      doMove(board, side > 0 ? side : (int)lround(sqrt((double)board.size())), move);
       return 0;
-}
\ No newline at end of file
+}
@@ -6,7 +6,8 @@
  * of moves required to reach the goal state from the initial state.
  * 
  * Goal state: "ABCDEFGHIJKLMNO#"
- * Where '#' represents the empty space.
+ * Where '#' represents the empty space. --goal <tablero> solves towards
+ * another board instead (see goal_relabel.h).
  * 
  * @author JAPeTo
  * @version 1.6
@@ -18,12 +19,24 @@
 #include <vector>
 #include <omp.h>
 #include <fstream>
+#include <atomic>
+#include <iterator>
+#include "search_budget.h"
+#include "result_writer.h"
+#include "puzzle_set.h"
+#include "thread_placement.h"
+#include "search_checkpoint.h"
+#include "goal_relabel.h"
 
 using namespace std;
 
 const int dRow[] = {-1, 1, 0, 0};
 const int dCol[] = {0, 0, -1, 1};
-const string GOAL = "ABCDEFGHIJKLMNO#";
+string GOAL = "ABCDEFGHIJKLMNO#";  // replaced by the relabeled --goal (see goal_relabel.h)
+SearchBudget searchBudget;
+CheckpointOptions checkpointOptions;
+bool verboseOutput = true;
+ThreadPlacement threadPlacement{PlacementOptions()};
 
 struct State {
     string board;
@@ -40,42 +53,100 @@ string swapBoardTiles(const string &currentBoard, int position1, int position2)
     return newBoard;
 }
 
-int parallel_bfs(string start) {
-    queue<State> q;
+/**
+ * @brief Level-synchronous parallel BFS run by one persistent thread team
+ *
+ * The team is created once per search. Each worker pins itself (see
+ * thread_placement.h) and keeps its own arena for the children it generates,
+ * reused level after level, so that memory stays on the worker's NUMA node.
+ * Workers only meet at the frontier exchange, where one of them moves the
+ * arenas into the next shared level.
+ *
+ * With --checkpoint the frontier exchange is also where snapshots are taken
+ * (see search_checkpoint.h): a level, its depth and the closed list. A level
+ * cut short by the budget is saved whole, with the closed list as it was
+ * before the level, so the resumed search expands it again from the start.
+ */
+int parallel_bfs(const string& start, SearchStats* stats = nullptr) {
     unordered_set<string> visited;
+    BudgetGuard guard(searchBudget, estimatedStateBytes(start.size()));
+    SearchCheckpoint checkpoint(checkpointOptions, "bsp_omp", "g=" + to_string(GOAL.find('#')), start);
+    atomic<long long> expandedNodes(0);
+    int depth = 0;
 
-    int blankPos = -1;
-    for (int i = 0; i < (int)start.size(); i++) {
-        if (start[i] == '#') {
-            blankPos = i;
-            break;
+    vector<State> level;
+    bool resumed = checkpoint.resume([&](SnapshotReader& in) {
+        expandedNodes = in.get<int64_t>();
+        depth = in.get<int32_t>();
+        uint64_t count = in.get<uint64_t>();
+        string board;
+        for (uint64_t i = 0; i < count; i++) {
+            in.getBoard(board, 16);
+            level.push_back(State(board, (int)board.find('#'), depth));
+        }
+        count = in.get<uint64_t>();
+        if (count > in.left() / 16) throw runtime_error("lista cerrada no válida");
+        visited.reserve(count);
+        for (uint64_t i = 0; i < count; i++) {
+            in.getBoard(board, 16);
+            visited.insert(board);
         }
+    });
+    if (resumed) {
+        if (verboseOutput) cout << "Reanudando desde " << checkpoint.path() << ": profundidad " << depth << ", "
+                                << visited.size() << " estados visitados" << endl;
+    } else {
+        expandedNodes = 0;
+        depth = 0;
+        level.assign(1, State(start, (int)start.find('#'), 0));
+        visited.clear();
+        visited.insert(start);
     }
 
-    q.push(State(start, blankPos, 0));
-    visited.insert(start);
+    // `fresh` are boards found while expanding `nodes`; they are left out of the closed list.
+    auto saveLevel = [&](const vector<State>& nodes, int cost, long long expanded, const unordered_set<string>& fresh) {
+        return checkpoint.save([&](SnapshotWriter& out) {
+            out.put<int64_t>(expanded);
+            out.put<int32_t>(cost);
+            out.put<uint64_t>(nodes.size());
+            for (const State& s : nodes) out.putBoard(s.board);
+            out.put<uint64_t>(visited.size() - fresh.size());
+            for (const string& board : visited) {
+                if (fresh.count(board) == 0) out.putBoard(board);
+            }
+        });
+    };
 
+    int threads = max(1, omp_get_max_threads());
+    vector<vector<State>> arenas(threads);
     bool found = false;
+    bool done = false;
+    bool saved = false;
+    bool interrupted = false;
+    long long levelStart = expandedNodes.load();
     int result_cost = -1;
 
-    while (!q.empty() && !found) {
-        int level_size = q.size();
-        vector<State> current_level;
+    #pragma omp parallel num_threads(threads)
+    {
+        int thread = omp_get_thread_num();
+        threadPlacement.pin(thread);
+        vector<State>& local_next_level = arenas[thread];
+        long long local_expanded = 0;
 
-        for (int i = 0; i < level_size; i++) {
-            current_level.push_back(q.front());
-            q.pop();
-        }
+        #pragma omp single
+        done = guard.overLimits(0, visited.size()) || guard.timeUp();
 
-        #pragma omp parallel
-        {
-            vector<State> local_next_level;
+        while (!done) {
+            #pragma omp for schedule(static)
+            for (int i = 0; i < (int)level.size(); i++) {
+                if (found || guard.tripped()) continue; 
 
-            #pragma omp for
-            for (int i = 0; i < level_size; i++) {
-                if (found) continue; 
+                if (++local_expanded % 256 == 0) {
+                    long long total = expandedNodes.fetch_add(256, memory_order_relaxed) + 256;
+                    if (guard.overLimits(total, 0) || guard.timeUp()) continue;
+                }
 
-                State current = current_level[i];
+                const State& current = level[i];
                 if (current.board == GOAL) {
                     #pragma omp critical
                     {
@@ -100,6 +171,7 @@ int parallel_bfs(string start) {
                         {
                             if (visited.find(newBoard) == visited.end()) {
                                 visited.insert(newBoard);
+                                guard.overLimits(0, visited.size());
                                 local_next_level.push_back(State(newBoard, newPos, current.cost + 1));
                             }
                         }
@@ -107,36 +179,138 @@ int parallel_bfs(string start) {
                 }
             }
 
-            #pragma omp critical
+            #pragma omp single
             {
-                for (const auto& state : local_next_level) {
-                    q.push(state);
+                bool cut = !found && guard.tripped();
+                if (cut && checkpoint.enabled()) {
+                    unordered_set<string> fresh;
+                    for (auto& arena : arenas) {
+                        for (const State& s : arena) fresh.insert(s.board);
+                    }
+                    saved = saveLevel(level, depth, levelStart, fresh);
+                }
+                level.clear();
+                for (auto& arena : arenas) {
+                    level.insert(level.end(), make_move_iterator(arena.begin()), make_move_iterator(arena.end()));
+                    arena.clear();
+                }
+                depth++;
+                levelStart = expandedNodes.load();
+                done = found || level.empty() || guard.overLimits(expandedNodes.load(), visited.size()) || guard.timeUp();
+                if (!cut && !found && !level.empty() && (checkpoint.due(1) || (done && checkpoint.enabled()))) {
+                    saved = saveLevel(level, depth, levelStart, unordered_set<string>());
+                    interrupted = checkpoint.interrupted();
+                    done = done || interrupted;
                 }
             }
         }
+
+        expandedNodes.fetch_add(local_expanded % 256, memory_order_relaxed);
+    }
+
+    if (stats) *stats = {expandedNodes.load(), visited.size()};
+    if (interrupted) {
+        if (verboseOutput) cout << "Búsqueda interrumpida; instantánea en " << checkpoint.path() << endl;
+        return BUDGET_EXCEEDED;
+    }
+    if (!found && guard.tripped()) {
+        if (verboseOutput) {
+            cout << "Presupuesto excedido (" << guard.reasonText() << ")" << endl;
+            cout << "Nodos expandidos: " << expandedNodes.load() << endl;
+            cout << "Estados visitados: " << visited.size() << endl;
+            cout << "Profundidad alcanzada: " << depth << endl;
+            if (saved) cout << "Instantánea en " << checkpoint.path() << endl;
+        }
+        return BUDGET_EXCEEDED;
     }
+    checkpoint.discard();
     return result_cost;
 }
 
-int main() {
+int main(int argc, char* argv[]) {
+    OutputFormat format = FORMAT_TEXT;
+    string inputPath = "puzzles.txt";
+    string goalText;
+    PlacementOptions placement;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--format" && i + 1 < argc && parseOutputFormat(argv[i + 1], format)) {
+            i++;
+        } else if (arg == "--input" && i + 1 < argc) {
+            inputPath = argv[++i];
+        } else if (arg == "--goal" && i + 1 < argc) {
+            goalText = argv[++i];
+        } else if (parsePlacementOption(i, argc, argv, placement)) {
+            continue;
+        } else if (parseCheckpointOption(i, argc, argv, checkpointOptions)) {
+            continue;
+        } else if (!parseBudgetOption(i, argc, argv, searchBudget)) {
+            cerr << "Uso: " << argv[0] << " [--bind none|compact|spread] [--sockets <n>] [--time-limit <s>] [--max-nodes <n>] [--max-mem <MB>] [--checkpoint <dir>] [--checkpoint-every <s>] [--format text|jsonl|csv] [--input <archivo>] [--goal <tablero>]" << endl;
+            return 1;
+        }
+    }
+    GoalRelabeling relabeling;
+    if (!goalText.empty()) {
+        vector<uint16_t> goal;
+        string error;
+        if (!parseTiles(goalText, 4, goal, error)) {
+            cerr << "Error: objetivo no válido " << goalText << ": " << error << endl;
+            return 1;
+        }
+        relabeling = GoalRelabeling(goal, 4);
+        GOAL = formatTiles(relabeling.goal(), 4);
+    }
+    verboseOutput = format == FORMAT_TEXT;
+    if (!checkpointOptions.directory.empty()) installCheckpointSignals();
+    threadPlacement = ThreadPlacement(placement);
+    if (verboseOutput && threadPlacement.enabled()) cout << "Hilos: " << threadPlacement.describe() << endl;
+
     string start;
-    ifstream file("puzzles.txt");  
+    BoardSource file(inputPath);
 
     if (!file.is_open()) {
-        cerr << "Error: No se pudo abrir puzzles.txt" << endl;
+        cerr << "Error: no se pudo abrir " << inputPath << endl;
+        return 1;
+    }
+    if (file.side() != 0 && file.side() != 4) {
+        cerr << "Error: el conjunto de tableros no es de 4x4" << endl;
         return 1;
     }
 
-    while (getline(file, start)) {
+    ResultWriter writer(stdout, format);
+    long long puzzleIndex = 0;
+    while (!checkpointStopRequested() && file.next(start)) {
         if (start.empty()) continue;  
+        puzzleIndex++;
+        vector<uint16_t> tiles;
+        string error;
+        if (!parseTiles(start, 4, tiles, error)) {
+            cerr << "Tablero no válido " << start << ": " << error << endl;
+            if (!verboseOutput) writer.write({puzzleIndex, start, INVALID_BOARD, SearchStats(), 0});
+            continue;
+        }
+        string board = formatTiles(relabeling.apply(tiles), 4);
+
+        if (!verboseOutput) {
+            SearchStats stats;
+            double start_time = omp_get_wtime();
+            int result = parallel_bfs(board, &stats);
+            // A signal stopped the search after its snapshot; a rerun resumes it.
+            if (checkpointStopRequested()) break;
+            writer.write({puzzleIndex, start, result, stats, omp_get_wtime() - start_time});
+            continue;
+        }
 
         cout << "Procesando tablero: " << start << endl;
 
         double start_time = omp_get_wtime();
-        int result = parallel_bfs(start);
+        int result = parallel_bfs(board);
         double end_time = omp_get_wtime();
+        if (checkpointStopRequested()) break;
 
-        if (result != -1)
+        if (result == BUDGET_EXCEEDED)
+            cout << "Resultado: presupuesto excedido" << endl;
+        else if (result != -1)
             cout << "Resultado: " << result << endl;
         else
             cout << "Sin solución encontrada." << endl;
@@ -145,6 +319,5 @@ int main() {
         cout << endl;
     }
 
-    file.close();
     return 0;
 }
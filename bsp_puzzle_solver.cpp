@@ -7,6 +7,18 @@
  * 
  * Goal state: "ABCDEFGHIJKLMNO#"
  * Where '#' represents the empty space.
+ *
+ * Boards use the unique tile IDs of puzzle_tiles.h; larger boards are given
+ * as comma-separated numbers with 0 (or '#') for the blank.
+ *
+ * With --backward the whole batch is answered by a single search from the
+ * goal (see backwardBfs), which pays off when many boards are shallow.
+ *
+ * With --checkpoint <dir> a long search saves its progress to disk and a
+ * rerun of the same command resumes it (see search_checkpoint.h).
+ *
+ * --goal <tablero> searches towards another goal; it is relabeled onto the
+ * canonical one together with every start (see goal_relabel.h).
  * 
  * @author JAPeTo
  * @version 1.6
@@ -15,9 +27,21 @@
 #include <iostream>
 #include <queue>
 #include <unordered_set>
+#include <unordered_map>
 #include <string>
 #include <chrono>
 #include <fstream>   
+#include <thread>
+#include <atomic>
+#include <vector>
+#include "search_budget.h"
+#include "result_writer.h"
+#include "puzzle_set.h"
+#include "puzzle_tiles.h"
+#include "macro_solver.h"
+#include "compact_closed_list.h"
+#include "search_checkpoint.h"
+#include "goal_relabel.h"
 using namespace std::chrono;
 using namespace std;
 
@@ -29,49 +53,117 @@ using namespace std;
 const int dRow[] = {-1, 1, 0, 0};
 const int dCol[] = {0, 0, -1, 1};
 const string MOVES[] = {"UP", "DOWN", "LEFT", "RIGHT"};
-string goal = "";
+string goal8;
+u16string goal16;
 int sizeBoard = 0;
+SearchBudget searchBudget;
+CheckpointOptions checkpointOptions;
+bool verboseOutput = true;
 
+template <class Board>
 struct State{
-      string board;
+      Board board;
       int blankPos;
       int cost;
-      State(string b, int pos, int c) : board(b), blankPos(pos), cost(c) {}
+      State(const Board& b, int pos, int c) : board(b), blankPos(pos), cost(c) {}
 };
 
-string swapBoardTiles(const string &currentBoard, int position1, int position2){
-      string newBoard = currentBoard;
-      char tmp = currentBoard[position1];
+const string& goalBoard(const string&) { return goal8; }
+const u16string& goalBoard(const u16string&) { return goal16; }
+
+template <class Board>
+Board swapBoardTiles(const Board &currentBoard, int position1, int position2){
+      Board newBoard = currentBoard;
+      auto tmp = currentBoard[position1];
       newBoard[position1] = currentBoard[position2];
       newBoard[position2] = tmp;
       return newBoard;
 }
 
-int bfs(string start){
+/**
+ * @brief Breadth-first search from `start`; with --checkpoint it snapshots and resumes (see search_checkpoint.h)
+ */
+template <class Board>
+int bfs(const Board& start, SearchStats* stats = nullptr){
+      typedef State<Board> State;
       int expandedNodes = 0;
       queue<State> q;
-      unordered_set<string> visited;
-      int blankPos = -1;
-      for (int i = 0; i < start.size(); i++){
-            if (start[i] == '#'){
-                  blankPos = i;
-            } 
-            if (blankPos >= 0)
-            {
-                  break;
+      ClosedList<Board> visited(start.size());
+      BudgetGuard guard(searchBudget, ClosedList<Board>::stateBytes(start));
+      SearchCheckpoint checkpoint(checkpointOptions, "bsp", "g=" + to_string(blankPosition(goalBoard(start))), start);
+      const Board& goal = goalBoard(start);
+      const size_t cells = start.size();
+
+      // `pending` is a node already popped but not expanded; it goes first.
+      auto saveSnapshot = [&](const State* pending){
+            return checkpoint.save([&](SnapshotWriter& out){
+                  const deque<State>& open = adaptorContainer(q);
+                  out.put<int64_t>(expandedNodes - (pending ? 1 : 0));
+                  out.put<uint64_t>(open.size() + (pending ? 1 : 0));
+                  auto putState = [&](const State& s){
+                        out.putBoard(s.board);
+                        out.put<int32_t>(s.cost);
+                  };
+                  if (pending) putState(*pending);
+                  for (const State& s : open) putState(s);
+                  visited.save(out);
+            });
+      };
+
+      bool resumed = checkpoint.resume([&](SnapshotReader& in){
+            expandedNodes = (int)in.get<int64_t>();
+            uint64_t count = in.get<uint64_t>();
+            Board board;
+            for (uint64_t i = 0; i < count; i++) {
+                  in.getBoard(board, cells);
+                  int cost = in.get<int32_t>();
+                  q.push(State(board, blankPosition(board), cost));
             }
+            visited.load(in, cells);
+      });
+      if (resumed) {
+            if (verboseOutput) cout << "Reanudando desde " << checkpoint.path() << ": " << expandedNodes
+                                    << " nodos expandidos, " << visited.size() << " estados visitados" << endl;
+      } else {
+            expandedNodes = 0;
+            q = queue<State>();
+            visited = ClosedList<Board>(cells);
+            q.push(State(start, blankPosition(start), 0));
+            visited.insert(start);
       }
-      q.push(State(start, blankPos, 0));
-      visited.insert(start);
 
       while (!q.empty()){
+            if (checkpoint.due()) {
+                  saveSnapshot(nullptr);
+                  if (checkpoint.interrupted()) {
+                        if (verboseOutput) cout << "Búsqueda interrumpida; instantánea en " << checkpoint.path() << endl;
+                        return BUDGET_EXCEEDED;
+                  }
+            }
+
             State current = q.front();
             q.pop();
             expandedNodes++;
+            if (stats) *stats = {expandedNodes, visited.size()};
+
+            if (guard.check(expandedNodes, visited.size())) {
+                  bool saved = saveSnapshot(&current);
+                  if (verboseOutput) {
+                        cout << "Presupuesto excedido (" << guard.reasonText() << ")" << endl;
+                        cout << "Nodos expandidos: " << expandedNodes << endl;
+                        cout << "Estados visitados: " << visited.size() << endl;
+                        cout << "Profundidad alcanzada: " << current.cost << endl;
+                        if (saved) cout << "Instantánea en " << checkpoint.path() << endl;
+                  }
+                  return BUDGET_EXCEEDED;
+            }
             
             if(current.board == goal){
-                  cout << "Nodos expandidos: " << expandedNodes << endl;
-                  cout << "Longitud de la solución: " << current.cost << endl;
+                  checkpoint.discard();
+                  if (verboseOutput) {
+                        cout << "Nodos expandidos: " << expandedNodes << endl;
+                        cout << "Longitud de la solución: " << current.cost << endl;
+                  }
                   return current.cost;
             }
 
@@ -85,74 +177,285 @@ int bfs(string start){
                   if (newRow >= 0 && newRow < sizeBoard && newCol >= 0 && newCol < sizeBoard){
                         int newPos = newRow * sizeBoard + newCol;
 
-                        string newBoard = swapBoardTiles(current.board, current.blankPos, newPos);
+                        Board newBoard = swapBoardTiles(current.board, current.blankPos, newPos);
 
-                        if (visited.find(newBoard) == visited.end()){
+                        if (visited.insert(newBoard)){
                               q.push(State(newBoard, newPos, current.cost + 1));
-                              visited.insert(newBoard);
                         }
                   }
             }
       }
-      cout << "Nodos expandidos: " << expandedNodes << endl;
+      checkpoint.discard();
+      if (verboseOutput) cout << "Nodos expandidos: " << expandedNodes << endl;
       return -1;
 }
 
+/**
+ * @brief Answer for one start of a backward batch
+ */
+struct BatchAnswer{
+      int cost = BUDGET_EXCEEDED;
+      SearchStats stats;
+      double seconds = 0;
+};
+
+/**
+ * @brief One breadth-first search from the goal that answers a whole batch of starts
+ *
+ * Moves are reversible, so the layer in which a board is first generated from
+ * the goal is its optimal distance. Starts are looked up as boards are
+ * generated and the search stops once every start has been reached, so a
+ * batch of shallow boards costs one search as deep as the deepest of them.
+ * Starts still pending when the budget runs out get BUDGET_EXCEEDED; if the
+ * space is exhausted they get -1.
+ */
+template <class Board>
+vector<BatchAnswer> backwardBfs(const vector<Board>& starts){
+      vector<BatchAnswer> answers(starts.size());
+      if (starts.empty()) return answers;
+      const Board& goal = goalBoard(starts[0]);
+      unordered_map<Board, vector<size_t>> pending;
+      for (size_t i = 0; i < starts.size(); i++) pending[starts[i]].push_back(i);
+
+      long long expandedNodes = 0;
+      ClosedList<Board> visited(goal.size());
+      BudgetGuard guard(searchBudget, ClosedList<Board>::stateBytes(goal));
+      auto resolve = [&](const Board& board, int depth) {
+            auto it = pending.find(board);
+            if (it == pending.end()) return;
+            for (size_t i : it->second) answers[i] = {depth, {expandedNodes, visited.size()}, guard.elapsed()};
+            pending.erase(it);
+      };
+
+      vector<Board> layer = {goal}, nextLayer;
+      visited.insert(goal);
+      resolve(goal, 0);
+      for (int depth = 1; !pending.empty() && !layer.empty(); depth++){
+            for (const Board& board : layer){
+                  expandedNodes++;
+                  if (guard.check(expandedNodes, visited.size())) break;
+                  int blankPos = blankPosition(board);
+                  int row = blankPos / sizeBoard;
+                  int col = blankPos % sizeBoard;
+                  for (int i = 0; i < 4; i++){
+                        int newRow = row + dRow[i];
+                        int newCol = col + dCol[i];
+                        if (newRow < 0 || newRow >= sizeBoard || newCol < 0 || newCol >= sizeBoard) continue;
+
+                        Board newBoard = swapBoardTiles(board, blankPos, newRow * sizeBoard + newCol);
+                        if (visited.insert(newBoard)){
+                              resolve(newBoard, depth);
+                              nextLayer.push_back(move(newBoard));
+                        }
+                  }
+                  if (pending.empty()) break;
+            }
+            if (guard.tripped()) break;
+            layer.swap(nextLayer);
+            nextLayer.clear();
+      }
+      int unresolved = guard.tripped() ? BUDGET_EXCEEDED : -1;
+      for (auto& entry : pending){
+            for (size_t i : entry.second) answers[i] = {unresolved, {expandedNodes, visited.size()}, guard.elapsed()};
+      }
+      return answers;
+}
+
+/**
+ * @brief Constructive, non-optimal solution for boards too large for optimal search
+ *
+ * Used by default from 16x16 up, or on request with --macro (see
+ * macro_solver.h). The residual IDA* nodes are reported as expanded nodes.
+ */
+int macroSearch(const vector<uint16_t>& tiles, const vector<uint16_t>& goalTiles, SearchStats* stats = nullptr){
+      MacroSolver solver(tiles, goalTiles, sizeBoard);
+      vector<int> moves;
+      int result = solver.solve(moves);
+      if (stats) *stats = {solver.residualNodes(), 0};
+      if (verboseOutput) {
+            if (result < 0) cout << "Tablero sin solución" << endl;
+            else cout << "Solución constructiva (no óptima): " << solver.macroMoves() << " movimientos de macros + "
+                      << result - (int)solver.macroMoves() << " del residuo" << endl;
+      }
+      return result;
+}
+
 int main(int argc, char* argv[]){
       if (argc < 2) {
-            cerr << "Uso: " << argv[0] << " <tamaño_tablero>" << endl;
+            cerr << "Uso: " << argv[0] << " <tamaño_tablero> [--time-limit <s>] [--max-nodes <n>] [--max-mem <MB>] [--checkpoint <dir>] [--checkpoint-every <s>] [--format text|jsonl|csv] [--jobs <n>] [--input <archivo>] [--goal <tablero>] [--macro|--optimal] [--backward]" << endl;
             return 1;
       }
 
       sizeBoard = stoi(argv[1]);
-      if(sizeBoard == 4){
-            goal = "ABCDEFGHIJKLMNO#";
-            cout << "Goal size: " << goal.size() << endl;
-      }
-      else if(sizeBoard == 8){
-            goal = "ABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJK#";
-            cout << "Goal size: " << goal.size() << endl;
+      OutputFormat format = FORMAT_TEXT;
+      int jobs = 1;
+      string inputPath = "puzzles.txt";
+      string goalText;
+      bool useMacro = sizeBoard >= MACRO_AUTO_SIDE;
+      bool backward = false;
+      for (int i = 2; i < argc; i++) {
+            string arg = argv[i];
+            if (arg == "--macro") useMacro = true;
+            else if (arg == "--optimal") useMacro = false;
+            else if (arg == "--backward") backward = true;
+            else if (arg == "--jobs" && i + 1 < argc) jobs = max(1, stoi(argv[++i]));
+            else if (arg == "--input" && i + 1 < argc) inputPath = argv[++i];
+            else if (arg == "--goal" && i + 1 < argc) goalText = argv[++i];
+            else if (arg == "--format" && i + 1 < argc && parseOutputFormat(argv[i + 1], format)) i++;
+            else if (parseCheckpointOption(i, argc, argv, checkpointOptions)) continue;
+            else if (!parseBudgetOption(i, argc, argv, searchBudget)) {
+                  cerr << "Opción desconocida: " << argv[i] << endl;
+                  return 1;
+            }
       }
-      else if(sizeBoard == 16){
-            goal = "ABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTU#";
-            cout << "Goal size: " << goal.size() << endl;
+      verboseOutput = format == FORMAT_TEXT && jobs == 1;
+      if (!checkpointOptions.directory.empty()) installCheckpointSignals();
+      if (sizeBoard < 2 || sizeBoard > 255) {
+            cerr << "Tamaño no soportado." << endl;
+            return 1;
       }
-      else if(sizeBoard == 32){
-            goal = "ABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHI#";            
-            cout << "Goal size: " << goal.size() << endl;
+      // A custom goal is relabeled onto the canonical layout (see goal_relabel.h); starts follow it.
+      GoalRelabeling relabeling;
+      if (!goalText.empty()) {
+            vector<uint16_t> goal;
+            string error;
+            if (!parseTiles(goalText, sizeBoard, goal, error)) {
+                  cerr << "Error: objetivo no válido " << goalText << ": " << error << endl;
+                  return 1;
+            }
+            relabeling = GoalRelabeling(goal, sizeBoard);
       }
+      vector<uint16_t> goalTiles = goalText.empty() ? canonicalGoalTiles(sizeBoard) : relabeling.goal();
+      if (usesWideTiles(sizeBoard)) goal16 = toBoard<u16string>(goalTiles);
+      else goal8 = toBoard<string>(goalTiles);
+      if (verboseOutput) cout << "Goal size: " << goalTiles.size() << endl;
+      if (verboseOutput && !goalText.empty()) cout << "Objetivo " << goalText << " reetiquetado como " << formatTiles(goalTiles, sizeBoard) << endl;
 
-      ifstream infile("puzzles.txt");
+      BoardSource infile(inputPath);
       if (!infile.is_open()) {
-            cerr << "Error: no se pudo abrir puzzles.txt" << endl;
+            cerr << "Error: no se pudo abrir " << inputPath << endl;
             return 1;
       }
+      if (infile.side() != 0 && infile.side() != sizeBoard) {
+            cerr << "Error: el conjunto de tableros no es de " << sizeBoard << "x" << sizeBoard << endl;
+            return 1;
+      }
+
+      auto solve = [&](const SourceBoard& input, SearchStats* stats) {
+            vector<uint16_t> tiles;
+            string error;
+            if (!input.parse(sizeBoard, tiles, error)) {
+                  cerr << "Tablero no válido " << input.text() << ": " << error << endl;
+                  return INVALID_BOARD;
+            }
+            tiles = relabeling.apply(tiles);
+            if (useMacro) return macroSearch(tiles, goalTiles, stats);
+            return usesWideTiles(sizeBoard) ? bfs(toBoard<u16string>(tiles), stats) : bfs(toBoard<string>(tiles), stats);
+      };
+
+      // An optional first board comes from stdin; with none, records are numbered as in h1/h2.
+      SourceBoard start;
+      cin >> start.line;
+      vector<SourceBoard> boards;
+      if (!start.empty()) boards.push_back(start);
+
+      if (backward) {
+            // One backward search answers every solvable board.
+            while (infile.next(start)) boards.push_back(start);
+
+            vector<BatchAnswer> answers(boards.size());
+            vector<size_t> searched;
+            vector<vector<uint16_t>> starts;
+            for (size_t i = 0; i < boards.size(); i++) {
+                  vector<uint16_t> tiles;
+                  string error;
+                  answers[i].cost = -1;
+                  if (!boards[i].parse(sizeBoard, tiles, error)) {
+                        cerr << "Tablero no válido " << boards[i].text() << ": " << error << endl;
+                        answers[i].cost = INVALID_BOARD;
+                        continue;
+                  }
+                  tiles = relabeling.apply(tiles);
+                  if (!isSolvable(tiles, goalTiles, sizeBoard)) continue;
+                  searched.push_back(i);
+                  starts.push_back(tiles);
+            }
+            auto run = [&](auto boardType) {
+                  typedef decltype(boardType) Board;
+                  vector<Board> typed;
+                  for (const auto& tiles : starts) typed.push_back(toBoard<Board>(tiles));
+                  vector<BatchAnswer> found = backwardBfs(typed);
+                  for (size_t k = 0; k < searched.size(); k++) answers[searched[k]] = found[k];
+            };
+            if (usesWideTiles(sizeBoard)) run(u16string());
+            else run(string());
+
+            ResultWriter writer(stdout, format);
+            for (size_t i = 0; i < boards.size(); i++)
+                  writer.write({(long long)i + 1, boards[i].text(), answers[i].cost, answers[i].stats, answers[i].seconds});
+            return 0;
+      }
+
+      if (!verboseOutput) {
+            // Records are tagged with the puzzle index and written as each worker finishes.
+            while (infile.next(start)) boards.push_back(start);
+
+            ResultWriter writer(stdout, format);
+            atomic<size_t> nextBoard(0);
+            auto worker = [&]() {
+                  size_t i;
+                  while (!checkpointStopRequested() && (i = nextBoard++) < boards.size()) {
+                        SearchStats stats;
+                        auto start_time = steady_clock::now();
+                        int result = solve(boards[i], &stats);
+                        // A signal stopped the search after its snapshot; a rerun resumes it.
+                        if (checkpointStopRequested()) break;
+                        double elapsed = duration<double>(steady_clock::now() - start_time).count();
+                        writer.write({(long long)i + 1, boards[i].text(), result, stats, elapsed});
+                  }
+            };
+            vector<thread> pool;
+            for (int t = 0; t < jobs; t++) pool.emplace_back(worker);
+            for (auto& t : pool) t.join();
+            return 0;
+      }
 
-      string start;
-      cin >> start;
-      cout << "Procesando tablero: " << start << endl;
+      if (!start.empty()) {
+            cout << "Procesando tablero: " << start.text() << endl;
 
             auto start_time = high_resolution_clock::now();
-            int result = bfs(start);
+            int result = solve(start, nullptr);
             auto end_time = high_resolution_clock::now();
+            if (checkpointStopRequested()) return 0;
 
             double elapsed = duration<double>(end_time - start_time).count();
-            cout << "Resultado: " << result << endl;
+            if (result == BUDGET_EXCEEDED)
+                  cout << "Resultado: presupuesto excedido" << endl;
+            else if (result == INVALID_BOARD)
+                  cout << "Resultado: tablero no válido" << endl;
+            else
+                  cout << "Resultado: " << result << endl;
             cout << "Tiempo de ejecución: " << elapsed << " segundos" << endl;
             cout << endl;
-      while (infile >> start) {
-            cout << "Procesando tablero: " << start << endl;
+      }
+      while (!checkpointStopRequested() && infile.next(start)) {
+            cout << "Procesando tablero: " << start.text() << endl;
 
             auto start_time = high_resolution_clock::now();
-            int result = bfs(start);
+            int result = solve(start, nullptr);
             auto end_time = high_resolution_clock::now();
+            if (checkpointStopRequested()) break;
 
             double elapsed = duration<double>(end_time - start_time).count();
-            cout << "Resultado: " << result << endl;
+            if (result == BUDGET_EXCEEDED)
+                  cout << "Resultado: presupuesto excedido" << endl;
+            else if (result == INVALID_BOARD)
+                  cout << "Resultado: tablero no válido" << endl;
+            else
+                  cout << "Resultado: " << result << endl;
             cout << "Tiempo de ejecución: " << elapsed << " segundos" << endl;
             cout << endl;
       }
 
-      infile.close();
       return 0;
 }
@@ -0,0 +1,306 @@
+/**
+ * @file compact_closed_list.h
+ * @brief Exact closed list in a few bytes per state (Cleary-style compact hashing)
+ *
+ * Boards of up to 16 cells are first mapped to their permutation rank, which
+ * fits in ceil(log2(cells!)) bits (45 for 4x4). The rank goes through an
+ * invertible mix of that width; the top q bits of the result pick the home
+ * slot of a 2^q table and only the remaining bits (the remainder) are stored.
+ * Collisions are resolved by linear probing and every slot also keeps its
+ * distance to the home slot, so the full key is recoverable from (slot,
+ * remainder, distance) and membership is exact.
+ *
+ * Slots are bit-packed: (keyBits - q) + 8 bits each, i.e. 29 bits at 2^24
+ * slots for 4x4 boards, about 5 bytes per state at the 3/4 load limit.
+ * insert() is the find-then-insert pair of unordered_set in a single probe.
+ *
+ * Larger boards do not fit a 64-bit rank; ClosedList falls back to
+ * unordered_set for them.
+ *
+ * save() and load() copy either form to and from a search snapshot (see
+ * search_checkpoint.h); the compact table goes out word for word, so
+ * resuming does not re-insert anything.
+ */
+#ifndef COMPACT_CLOSED_LIST_H
+#define COMPACT_CLOSED_LIST_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include "puzzle_tiles.h"
+#include "search_budget.h"
+
+const size_t COMPACT_MAX_CELLS = 16;
+
+/**
+ * @brief Bits needed for the rank of a permutation of `cells` tiles
+ */
+inline int permutationBits(size_t cells) {
+    double states = 1;
+    for (size_t i = 2; i <= cells; i++) states *= (double)i;
+    int bits = 1;
+    while (bits < 64 && (double)(1ULL << bits) < states) bits++;
+    return bits;
+}
+
+/**
+ * @brief Lehmer rank of a board whose tiles are 0..cells-1, cells <= 16
+ */
+template <class Board>
+inline uint64_t permutationRank(const Board& board) {
+    const size_t cells = board.size();
+    uint32_t used = 0;
+    uint64_t rank = 0;
+    for (size_t i = 0; i < cells; i++) {
+        int tile = tileAt(board[i]);
+        int smaller = tile - __builtin_popcount(used & ((1u << tile) - 1));
+        rank = rank * (cells - i) + (uint64_t)smaller;
+        used |= 1u << tile;
+    }
+    return rank;
+}
+
+/**
+ * @brief Exact set of keyBits-bit integers stored as quotient-table remainders
+ */
+class CompactSet {
+public:
+    static const int DISTANCE_BITS = 8;
+    static const int MIN_SLOT_BITS = 16;
+
+    explicit CompactSet(int keyBits, int slotBits = MIN_SLOT_BITS)
+        : keyBits_(keyBits < 32 ? 32 : keyBits) {
+        reset(slotBits);
+    }
+
+    /**
+     * @brief Adds `key`; true when it was not in the set
+     */
+    bool insert(uint64_t key) {
+        if (size_ + 1 > capacity() / 4 * 3) grow();
+        uint64_t h = mix(key);
+        while (true) {
+            int result = place(h);
+            if (result >= 0) {
+                size_ += (size_t)result;
+                return result == 1;
+            }
+            grow();
+        }
+    }
+
+    bool contains(uint64_t key) const {
+        uint64_t h = mix(key);
+        size_t home = (size_t)(h >> remainderBits_);
+        uint64_t remainder = h & remainderMask_;
+        for (uint64_t distance = 0;; distance++) {
+            uint64_t slot = get((home + distance) & (capacity() - 1));
+            if (slot == 0) return false;
+            if ((slot >> remainderBits_) == distance + 1 && (slot & remainderMask_) == remainder) return true;
+        }
+    }
+
+    size_t size() const { return size_; }
+
+    size_t capacity() const { return (size_t)1 << slotBits_; }
+
+    size_t bytes() const { return words_.size() * sizeof(uint64_t); }
+
+    /**
+     * @brief Writes the table as is (parameters and packed words) to a SnapshotWriter
+     */
+    template <class Writer>
+    void save(Writer& out) const {
+        out.template put<int32_t>(keyBits_);
+        out.template put<int32_t>(slotBits_);
+        out.template put<uint64_t>(size_);
+        out.putVector(words_);
+    }
+
+    /**
+     * @brief Replaces the contents with a table written by save()
+     */
+    template <class Reader>
+    void load(Reader& in) {
+        int keyBits = in.template get<int32_t>();
+        int slotBits = in.template get<int32_t>();
+        uint64_t size = in.template get<uint64_t>();
+        if (keyBits != keyBits_ || slotBits < 1 || slotBits > keyBits) throw std::runtime_error("lista cerrada no válida");
+        reset(slotBits);
+        size_t words = words_.size();
+        in.getVector(words_);
+        if (words_.size() != words || size > capacity()) throw std::runtime_error("lista cerrada no válida");
+        size_ = (size_t)size;
+    }
+
+private:
+    /**
+     * @brief Bijection on keyBits_ bits (odd multiply and xorshift are invertible mod 2^k)
+     */
+    uint64_t mix(uint64_t key) const {
+        uint64_t mask = keyBits_ == 64 ? ~0ULL : (1ULL << keyBits_) - 1;
+        key = (key * 0x9E3779B97F4A7C15ULL) & mask;
+        key ^= key >> (keyBits_ / 2);
+        key = (key * 0xC2B2AE3D27D4EB4FULL) & mask;
+        key ^= key >> (keyBits_ / 2 + 1);
+        return key;
+    }
+
+    /**
+     * @brief 1 if h was added, 0 if present, -1 if the probe ran past the distance field
+     */
+    int place(uint64_t h) {
+        size_t home = (size_t)(h >> remainderBits_);
+        uint64_t remainder = h & remainderMask_;
+        const uint64_t maxDistance = (1ULL << DISTANCE_BITS) - 2;
+        for (uint64_t distance = 0; distance <= maxDistance; distance++) {
+            size_t index = (home + distance) & (capacity() - 1);
+            uint64_t slot = get(index);
+            if (slot == 0) {
+                set(index, ((distance + 1) << remainderBits_) | remainder);
+                return 1;
+            }
+            if ((slot >> remainderBits_) == distance + 1 && (slot & remainderMask_) == remainder) return 0;
+        }
+        return -1;
+    }
+
+    void reset(int slotBits) {
+        slotBits_ = slotBits < keyBits_ ? slotBits : keyBits_;
+        remainderBits_ = keyBits_ - slotBits_;
+        remainderMask_ = remainderBits_ == 64 ? ~0ULL : (1ULL << remainderBits_) - 1;
+        width_ = remainderBits_ + DISTANCE_BITS;
+        words_.assign((capacity() * width_ + 63) / 64 + 1, 0);
+    }
+
+    /**
+     * @brief Doubles the table, rebuilding every key from its slot, remainder and distance
+     */
+    void grow() {
+        std::vector<uint64_t> old;
+        old.swap(words_);
+        size_t oldCapacity = capacity();
+        int oldSlotBits = slotBits_, oldRemainderBits = remainderBits_, oldWidth = width_;
+        uint64_t oldMask = remainderMask_;
+        for (int slotBits = oldSlotBits + 1;; slotBits++) {
+            reset(slotBits);
+            bool placed = true;
+            for (size_t index = 0; placed && index < oldCapacity; index++) {
+                uint64_t slot = read(old, index, oldWidth);
+                if (slot == 0) continue;
+                uint64_t distance = (slot >> oldRemainderBits) - 1;
+                uint64_t home = (index - distance) & (oldCapacity - 1);
+                placed = place((home << oldRemainderBits) | (slot & oldMask)) >= 0;
+            }
+            if (placed) return;
+        }
+    }
+
+    static uint64_t read(const std::vector<uint64_t>& words, size_t index, int width) {
+        size_t bit = index * (size_t)width;
+        size_t word = bit >> 6;
+        int offset = (int)(bit & 63);
+        uint64_t value = words[word] >> offset;
+        if (offset + width > 64) value |= words[word + 1] << (64 - offset);
+        return width == 64 ? value : value & ((1ULL << width) - 1);
+    }
+
+    uint64_t get(size_t index) const { return read(words_, index, width_); }
+
+    void set(size_t index, uint64_t value) {
+        size_t bit = index * (size_t)width_;
+        size_t word = bit >> 6;
+        int offset = (int)(bit & 63);
+        uint64_t mask = width_ == 64 ? ~0ULL : (1ULL << width_) - 1;
+        words_[word] = (words_[word] & ~(mask << offset)) | (value << offset);
+        if (offset + width_ > 64) {
+            int spill = 64 - offset;
+            words_[word + 1] = (words_[word + 1] & ~(mask >> spill)) | (value >> spill);
+        }
+    }
+
+    int keyBits_;
+    int slotBits_ = 0;
+    int remainderBits_ = 0;
+    int width_ = 0;
+    uint64_t remainderMask_ = 0;
+    size_t size_ = 0;
+    std::vector<uint64_t> words_;
+};
+
+/**
+ * @brief Closed list of boards: compact for up to 16 cells, unordered_set above
+ */
+template <class Board>
+class ClosedList {
+public:
+    explicit ClosedList(size_t cells) {
+        if (cells <= COMPACT_MAX_CELLS) compact_.reset(new CompactSet(permutationBits(cells)));
+    }
+
+    /**
+     * @brief Adds `board`; true when it was not in the list
+     */
+    bool insert(const Board& board) {
+        return compact_ ? compact_->insert(permutationRank(board)) : hashed_.insert(board).second;
+    }
+
+    bool contains(const Board& board) const {
+        return compact_ ? compact_->contains(permutationRank(board)) : hashed_.count(board) != 0;
+    }
+
+    size_t size() const { return compact_ ? compact_->size() : hashed_.size(); }
+
+    /**
+     * @brief Writes the list to a SnapshotWriter: the compact table, or every board of the fallback set
+     */
+    template <class Writer>
+    void save(Writer& out) const {
+        if (compact_) {
+            compact_->save(out);
+            return;
+        }
+        out.template put<uint64_t>(hashed_.size());
+        for (const Board& board : hashed_) out.putBoard(board);
+    }
+
+    /**
+     * @brief Replaces the contents with a list written by save() for boards of `cells` cells
+     */
+    template <class Reader>
+    void load(Reader& in, size_t cells) {
+        if (compact_) {
+            compact_->load(in);
+            return;
+        }
+        hashed_.clear();
+        uint64_t count = in.template get<uint64_t>();
+        if (count > in.left() / (cells * sizeof(typename Board::value_type))) throw std::runtime_error("lista cerrada no válida");
+        hashed_.reserve(count);
+        Board board;
+        for (uint64_t i = 0; i < count; i++) {
+            in.getBoard(board, cells);
+            hashed_.insert(board);
+        }
+    }
+
+    /**
+     * @brief Approximate bytes per stored state for BudgetGuard (closed entry plus open-list copy)
+     */
+    static size_t stateBytes(const Board& board) {
+        size_t length = board.size() * sizeof(board[0]);
+        if (board.size() > COMPACT_MAX_CELLS) return estimatedStateBytes(length);
+        size_t heap = length > 15 ? ((length + 16) & ~size_t(15)) : 0;
+        return sizeof(Board) + heap + 8;
+    }
+
+private:
+    std::unique_ptr<CompactSet> compact_;
+    std::unordered_set<Board> hashed_;
+};
+
+#endif
@@ -0,0 +1,388 @@
+/**
+ * @file dist_puzzle_solver.cpp
+ * @brief 4x4 Sliding Puzzle Solver distributed over several processes (BFS or A*)
+ *
+ * States are packed in a uint64 (one tile ID per nibble, see move_replay.h)
+ * and partitioned over P worker processes by a hash of the board: each
+ * process owns the visited set and the frontier of its share of the states.
+ * Children owned by another process are sent to it in batches through a
+ * RoundExchange (message_transport.h).
+ *
+ *   - BFS is level-synchronous: every level is one round, and a status round
+ *     between levels decides whether the goal was reached, the frontier is
+ *     empty or a budget was hit.
+ *   - A* (--astar) is a bulk-synchronous hash-distributed A*: in each round
+ *     every process expands up to ASTAR_ROUND_NODES of its best open nodes.
+ *     Reaching the goal only sets an incumbent; the search stops when no
+ *     open node anywhere has f below the incumbent, so the cost is optimal.
+ *
+ * Transports: "sockets" (default) forks the workers on this host and joins
+ * them with socketpairs; "mpi" needs a build with -DPUZZLE_WITH_MPI and
+ * mpirun, and puts one worker in each MPI rank.
+ *
+ * Compilation:
+ *      g++ -std=c++17 -O2 -o dist_puzzle_solver dist_puzzle_solver.cpp
+ *      mpicxx -std=c++17 -O2 -DPUZZLE_WITH_MPI -o dist_puzzle_solver dist_puzzle_solver.cpp
+ *
+ * Usage:
+ *      ./dist_puzzle_solver --workers 4 [--astar]
+ *      mpirun -np 8 ./dist_puzzle_solver --transport mpi --astar
+ */
+
+#include <iostream>
+#include <queue>
+#include <unordered_set>
+#include <unordered_map>
+#include <vector>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <memory>
+#include "search_budget.h"
+#include "result_writer.h"
+#include "puzzle_set.h"
+#include "puzzle_tiles.h"
+#include "move_replay.h"
+#include "message_transport.h"
+
+using namespace std;
+
+const size_t BATCH_ITEMS = 4096;
+const int ASTAR_ROUND_NODES = 2048;
+const size_t PACKED_STATE_BYTES = 2 * sizeof(uint64_t) + 3 * sizeof(void*) + 16;
+
+SearchBudget searchBudget;
+bool verboseOutput = true;
+MoveTable moveTable(4);
+uint64_t packedGoal = 0;
+int goalDistance[16][16];
+
+/**
+ * @brief Process that owns a board
+ */
+int ownerOf(uint64_t board, int workers) {
+    board ^= board >> 33;
+    board *= 0xFF51AFD7ED558CCDULL;
+    board ^= board >> 33;
+    board *= 0xC4CEB9FE1A85EC53ULL;
+    board ^= board >> 33;
+    return (int)(board % (uint64_t)workers);
+}
+
+int blankOf(uint64_t board) {
+    int blank = 0;
+    while ((board >> (4 * blank)) & 0xF) blank++;
+    return blank;
+}
+
+uint64_t movedBoard(uint64_t board, int blank, int next) {
+    uint64_t tile = (board >> (4 * next)) & 0xF;
+    return (board & ~(0xFULL << (4 * next))) | (tile << (4 * blank));
+}
+
+int manhattan(uint64_t board) {
+    int total = 0;
+    for (int cell = 0; cell < 16; cell++) total += goalDistance[(board >> (4 * cell)) & 0xF][cell];
+    return total;
+}
+
+void buildGoalDistance() {
+    vector<uint16_t> goal = canonicalGoalTiles(4);
+    packedGoal = packBoard16(goal);
+    for (int target = 0; target < 16; target++) {
+        int tile = goal[target];
+        for (int cell = 0; cell < 16; cell++)
+            goalDistance[tile][cell] = tile == BLANK_TILE ? 0 : abs(cell / 4 - target / 4) + abs(cell % 4 - target % 4);
+    }
+}
+
+long long sumOf(const vector<vector<long long>>& all, int index) {
+    long long total = 0;
+    for (const auto& counters : all) total += counters[index];
+    return total;
+}
+
+long long minOf(const vector<vector<long long>>& all, int index) {
+    long long best = LLONG_MAX;
+    for (const auto& counters : all) best = min(best, counters[index]);
+    return best;
+}
+
+/**
+ * @brief Level-synchronous BFS over the processes of `exchange`
+ */
+int distributedBfs(RoundExchange& exchange, uint64_t start, SearchStats* stats = nullptr) {
+    const int self = exchange.rank(), workers = exchange.size();
+    unordered_set<uint64_t> visited;
+    vector<uint64_t> frontier, next;
+    BudgetGuard guard(searchBudget, PACKED_STATE_BYTES);
+    long long expandedNodes = 0, totalExpanded = 0;
+    bool found = false;
+    auto noItems = [](const uint64_t*) {};
+
+    auto accept = [&](const uint64_t* item) {
+        if (!visited.insert(*item).second) return;
+        next.push_back(*item);
+        if (*item == packedGoal) found = true;
+    };
+    if (ownerOf(start, workers) == self) accept(&start);
+    frontier.swap(next);
+
+    enum { FOUND, FRONTIER, EXPANDED, STORED, TRIPPED };
+    for (int depth = 0;; depth++) {
+        bool tripped = guard.overLimits(totalExpanded, visited.size()) || guard.timeUp();
+        auto all = exchange.finish({found, (long long)frontier.size(), expandedNodes, (long long)visited.size(), tripped}, noItems);
+        totalExpanded = sumOf(all, EXPANDED);
+        if (stats) *stats = {totalExpanded, (size_t)sumOf(all, STORED)};
+        if (sumOf(all, FOUND) > 0) {
+            if (verboseOutput) {
+                cout << "Nodos expandidos: " << totalExpanded << endl;
+                cout << "Estados visitados: " << sumOf(all, STORED) << endl;
+            }
+            return depth;
+        }
+        if (sumOf(all, TRIPPED) > 0) {
+            if (verboseOutput) {
+                cout << "Presupuesto excedido" << endl;
+                cout << "Nodos expandidos: " << totalExpanded << endl;
+                cout << "Estados visitados: " << sumOf(all, STORED) << endl;
+                cout << "Profundidad alcanzada: " << depth << endl;
+            }
+            return BUDGET_EXCEEDED;
+        }
+        if (sumOf(all, FRONTIER) == 0) return -1;
+
+        for (size_t i = 0; i < frontier.size(); i++) {
+            uint64_t board = frontier[i];
+            int blank = blankOf(board);
+            uint8_t mask = moveTable.mask(blank);
+            for (int move = 0; move < 4; move++) {
+                if (!(mask & (1 << move))) continue;
+                uint64_t child = movedBoard(board, blank, moveTable.target(blank, move));
+                int owner = ownerOf(child, workers);
+                if (owner == self) accept(&child);
+                else exchange.add(owner, &child);
+            }
+            expandedNodes++;
+            if (i % 1024 == 1023) exchange.poll(accept);
+        }
+        exchange.finish({}, accept);
+        frontier.swap(next);
+        next.clear();
+    }
+}
+
+/**
+ * @brief Open-list entry of the distributed A*
+ */
+struct PackedNode {
+    int f;
+    int cost;
+    uint64_t board;
+
+    bool operator>(const PackedNode& other) const {
+        if (f != other.f) return f > other.f;
+        return cost < other.cost;
+    }
+};
+
+/**
+ * @brief Hash-distributed A* in synchronous rounds over the processes of `exchange`
+ */
+int distributedAStar(RoundExchange& exchange, uint64_t start, SearchStats* stats = nullptr) {
+    const int self = exchange.rank(), workers = exchange.size();
+    priority_queue<PackedNode, vector<PackedNode>, greater<PackedNode>> open;
+    unordered_map<uint64_t, uint8_t> best;
+    BudgetGuard guard(searchBudget, PACKED_STATE_BYTES);
+    long long expandedNodes = 0, totalExpanded = 0;
+    long long incumbent = INT_MAX;
+
+    // Items are (board, g); the owner keeps the child only if it improves g.
+    auto accept = [&](const uint64_t* item) {
+        uint64_t board = item[0];
+        int cost = (int)item[1];
+        auto it = best.find(board);
+        if (it != best.end() && it->second <= cost) return;
+        best[board] = (uint8_t)cost;
+        if (board == packedGoal) incumbent = min(incumbent, (long long)cost);
+        else open.push({cost + manhattan(board), cost, board});
+    };
+    auto noItems = [](const uint64_t*) {};
+    auto dropStale = [&]() {
+        while (!open.empty() && best[open.top().board] != open.top().cost) open.pop();
+    };
+    if (ownerOf(start, workers) == self) {
+        uint64_t item[2] = {start, 0};
+        accept(item);
+    }
+
+    enum { MIN_F, INCUMBENT, EXPANDED, STORED, TRIPPED };
+    while (true) {
+        dropStale();
+        bool tripped = guard.overLimits(totalExpanded, best.size()) || guard.timeUp();
+        long long minF = open.empty() ? LLONG_MAX : open.top().f;
+        auto all = exchange.finish({minF, incumbent, expandedNodes, (long long)best.size(), tripped}, noItems);
+        incumbent = minOf(all, INCUMBENT);
+        totalExpanded = sumOf(all, EXPANDED);
+        if (stats) *stats = {totalExpanded, (size_t)sumOf(all, STORED)};
+        if (minOf(all, MIN_F) >= incumbent) {
+            if (verboseOutput) {
+                cout << "Nodos expandidos: " << totalExpanded << endl;
+                cout << "Estados visitados: " << sumOf(all, STORED) << endl;
+            }
+            return incumbent == INT_MAX ? -1 : (int)incumbent;
+        }
+        if (sumOf(all, TRIPPED) > 0) {
+            if (verboseOutput) {
+                cout << "Presupuesto excedido" << endl;
+                cout << "Nodos expandidos: " << totalExpanded << endl;
+                cout << "Estados visitados: " << sumOf(all, STORED) << endl;
+                cout << "Mejor f en la frontera: " << minOf(all, MIN_F) << endl;
+            }
+            return BUDGET_EXCEEDED;
+        }
+
+        for (int expanded = 0; expanded < ASTAR_ROUND_NODES; expanded++) {
+            dropStale();
+            if (open.empty() || open.top().f >= incumbent) break;
+            PackedNode current = open.top();
+            open.pop();
+            int blank = blankOf(current.board);
+            uint8_t mask = moveTable.mask(blank);
+            for (int move = 0; move < 4; move++) {
+                if (!(mask & (1 << move))) continue;
+                uint64_t item[2] = {movedBoard(current.board, blank, moveTable.target(blank, move)), (uint64_t)current.cost + 1};
+                if ((long long)item[1] + manhattan(item[0]) >= incumbent) continue;
+                int owner = ownerOf(item[0], workers);
+                if (owner == self) accept(item);
+                else exchange.add(owner, item);
+            }
+            expandedNodes++;
+            if (expanded % 256 == 255) exchange.poll(accept);
+        }
+        exchange.finish({}, accept);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    OutputFormat format = FORMAT_TEXT;
+    string inputPath = "puzzles.txt";
+    string transportName = "sockets";
+    int workers = 2;
+    bool useAStar = false;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--astar") {
+            useAStar = true;
+        } else if (arg == "--workers" && i + 1 < argc) {
+            workers = max(1, stoi(argv[++i]));
+        } else if (arg == "--transport" && i + 1 < argc) {
+            transportName = argv[++i];
+        } else if (arg == "--format" && i + 1 < argc && parseOutputFormat(argv[i + 1], format)) {
+            i++;
+        } else if (arg == "--input" && i + 1 < argc) {
+            inputPath = argv[++i];
+        } else if (!parseBudgetOption(i, argc, argv, searchBudget)) {
+            cerr << "Uso: " << argv[0] << " [--workers <p>] [--transport sockets|mpi] [--astar] [--time-limit <s>] [--max-nodes <n>] [--max-mem <MB>] [--format text|jsonl|csv] [--input <archivo>]" << endl;
+            return 1;
+        }
+    }
+    if (transportName != "sockets" && transportName != "mpi") {
+        cerr << "Transporte desconocido: " << transportName << endl;
+        return 1;
+    }
+#ifndef PUZZLE_WITH_MPI
+    if (transportName == "mpi") {
+        cerr << "Este ejecutable se compiló sin MPI (-DPUZZLE_WITH_MPI)" << endl;
+        return 1;
+    }
+#else
+    if (transportName == "mpi") MPI_Init(&argc, &argv);
+#endif
+    verboseOutput = format == FORMAT_TEXT;
+    buildGoalDistance();
+
+    BoardSource infile(inputPath);
+    if (!infile.is_open()) {
+        cerr << "Error: no se pudo abrir " << inputPath << endl;
+        return 1;
+    }
+    if (infile.side() != 0 && infile.side() != 4) {
+        cerr << "Error: el conjunto de tableros no es de 4x4" << endl;
+        return 1;
+    }
+    vector<SourceBoard> boards;
+    SourceBoard start;
+    while (infile.next(start)) boards.push_back(start);
+
+    unique_ptr<Transport> transport;
+    vector<pid_t> children;
+    try {
+#ifdef PUZZLE_WITH_MPI
+        if (transportName == "mpi") transport.reset(new MpiTransport());
+#endif
+        if (!transport) {
+            cout.flush();
+            fflush(stdout);
+            transport = forkLocalWorkers(workers, children);
+        }
+    } catch (const runtime_error& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+    const bool leader = transport->rank() == 0;
+    if (!leader) verboseOutput = false;
+    RoundExchange exchange(*transport, useAStar ? 2 : 1, BATCH_ITEMS);
+
+    int status = 0;
+    try {
+        unique_ptr<ResultWriter> writer;
+        if (leader && !verboseOutput) writer.reset(new ResultWriter(stdout, format));
+        if (verboseOutput) cout << "Procesos: " << transport->size() << endl;
+        long long puzzleIndex = 0;
+        for (const SourceBoard& input : boards) {
+            puzzleIndex++;
+            string text = input.text();
+            vector<uint16_t> tiles;
+            string error;
+            if (!input.parse(4, tiles, error)) {
+                if (leader) cerr << "Tablero no válido " << text << ": " << error << endl;
+                if (writer) writer->write({puzzleIndex, text, INVALID_BOARD, SearchStats(), 0});
+                continue;
+            }
+            uint64_t packed = packBoard16(tiles);
+            if (verboseOutput) cout << "Procesando tablero: " << text << endl;
+
+            SearchStats stats;
+            auto start_time = chrono::steady_clock::now();
+            int result = useAStar ? distributedAStar(exchange, packed, &stats) : distributedBfs(exchange, packed, &stats);
+            double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start_time).count();
+
+            if (writer) {
+                writer->write({puzzleIndex, text, result, stats, elapsed});
+            } else if (verboseOutput) {
+                if (result == BUDGET_EXCEEDED)
+                    cout << "Resultado: presupuesto excedido" << endl;
+                else if (result != -1)
+                    cout << "Resultado: " << result << endl;
+                else
+                    cout << "Sin solución encontrada." << endl;
+                cout << "Tiempo de ejecución: " << elapsed << " segundos." << endl;
+                cout << endl;
+            }
+        }
+    } catch (const runtime_error& e) {
+        cerr << "Proceso " << transport->rank() << ": " << e.what() << endl;
+        status = 1;
+    }
+
+    transport.reset();
+    if (!children.empty() && !waitLocalWorkers(children)) {
+        cerr << "Error: algún proceso trabajador terminó con error" << endl;
+        status = 1;
+    }
+#ifdef PUZZLE_WITH_MPI
+    if (transportName == "mpi") MPI_Finalize();
+#endif
+    return status;
+}
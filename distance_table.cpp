@@ -0,0 +1,267 @@
+/**
+ * @file distance_table.cpp
+ * @brief Parallel builder of exact distance tables (see distance_table.h)
+ *
+ * Enumerates the complete state space of a small board (2x3, 2x4, 3x3, ...)
+ * or of a tile pattern of a larger one with a level-synchronous BFS from the
+ * goal. Moves are reversible, so the distances found from the goal are the
+ * distances to it. The table is a dense byte array indexed by placement rank:
+ * at level d every thread scans its share of the array for entries equal to
+ * d, unranks them, and claims each unvisited neighbour with an atomic
+ * compare-and-swap of its byte from 255 to d + 1. No frontier lists or hash
+ * sets are kept, so memory is exactly one byte per entry.
+ *
+ * All levels run in one persistent thread team. With --bind each worker pins
+ * itself before touching the array (see thread_placement.h) and the static
+ * initialization spreads the pages over the workers' NUMA nodes.
+ *
+ * Compilation:
+ *      g++ -std=c++17 -O2 -fopenmp -o distance_table distance_table.cpp
+ *
+ * Usage:
+ *      ./distance_table <filas>x<columnas> <salida.pdt> [--goal <tablero>] [--tiles <fichas>] [--bind none|compact|spread] [--sockets <n>]
+ *      ./distance_table --query <tabla.pdt> <tablero>...
+ *
+ * Without --tiles every tile is in the pattern (the whole state space).
+ * --tiles takes letters ("ABCEF") or comma-separated IDs ("1,2,3,5,6").
+ * The goal defaults to tiles 1..N-1 in order with the blank last; any other
+ * layout can be given with --goal, in the board formats of puzzle_tiles.h.
+ * The thread count comes from OMP_NUM_THREADS.
+ */
+
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <omp.h>
+#include "distance_table.h"
+#include "thread_placement.h"
+
+using namespace std;
+
+const uint64_t MAX_TABLE_ENTRIES = 1ULL << 32;
+const uint64_t SCAN_CHUNK = 1 << 14;
+
+ThreadPlacement threadPlacement{PlacementOptions()};
+
+/**
+ * @brief Parses a --tiles list: letters or comma-separated tile IDs
+ */
+bool parsePattern(const string& text, int cells, vector<uint16_t>& pattern, string& error) {
+    pattern.clear();
+    bool letters = text.find(',') == string::npos && text.find_first_not_of("ABCDEFGHIJKLMNOPQRSTUVWXYZ") == string::npos;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        int tile;
+        if (letters) {
+            tile = text[pos++] - 'A' + 1;
+        } else {
+            size_t comma = text.find(',', pos);
+            if (comma == string::npos) comma = text.size();
+            string field = text.substr(pos, comma - pos);
+            pos = comma + 1;
+            if (field.empty() || field.size() > 3 || field.find_first_not_of("0123456789") != string::npos) {
+                error = "ficha no válida '" + field + "'";
+                return false;
+            }
+            tile = stoi(field);
+        }
+        if (tile <= 0 || tile >= cells) {
+            error = "las fichas del patrón deben ser 1.." + to_string(cells - 1);
+            return false;
+        }
+        for (uint16_t seen : pattern) {
+            if (seen == tile) {
+                error = "ficha repetida en el patrón";
+                return false;
+            }
+        }
+        pattern.push_back((uint16_t)tile);
+    }
+    if (pattern.empty()) {
+        error = "el patrón está vacío";
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Level-synchronous BFS from the goal placement; returns the largest distance, -1 if it does not fit a byte
+ */
+int buildTable(const DistanceTableShape& shape, vector<uint8_t>& distances, uint64_t& reachable) {
+    const int rows = shape.rows, cols = shape.cols, cells = shape.cells(), objects = shape.objects();
+    PlacementRanker ranker(cells, objects);
+    const uint64_t entries = ranker.size();
+    distances.resize(entries);
+    uint8_t* table = distances.data();
+
+    int goalPosition[DISTANCE_TABLE_MAX_CELLS];
+    shape.placement(shape.goal, goalPosition);
+    const uint64_t goalRank = ranker.rank(goalPosition);
+
+    int level = 0;
+    long long added = 0;
+    bool done = false, overflow = false;
+    reachable = 1;
+
+    #pragma omp parallel
+    {
+        threadPlacement.pin(omp_get_thread_num());
+
+        #pragma omp for schedule(static)
+        for (uint64_t i = 0; i < entries; i++) table[i] = DISTANCE_UNREACHED;
+
+        #pragma omp single
+        table[goalRank] = 0;
+
+        while (!done) {
+            #pragma omp for schedule(dynamic, SCAN_CHUNK) reduction(+:added)
+            for (uint64_t rank = 0; rank < entries; rank++) {
+                if (__atomic_load_n(&table[rank], __ATOMIC_RELAXED) != level) continue;
+                int position[DISTANCE_TABLE_MAX_CELLS];
+                int occupant[DISTANCE_TABLE_MAX_CELLS];
+                ranker.unrank(rank, position);
+                for (int cell = 0; cell < cells; cell++) occupant[cell] = -1;
+                for (int i = 1; i < objects; i++) occupant[position[i]] = i;
+
+                int blank = position[0];
+                int row = blank / cols, col = blank % cols;
+                int next[4] = {row > 0 ? blank - cols : -1, row < rows - 1 ? blank + cols : -1,
+                               col > 0 ? blank - 1 : -1, col < cols - 1 ? blank + 1 : -1};
+                for (int move = 0; move < 4; move++) {
+                    int target = next[move];
+                    if (target < 0) continue;
+                    int moved = occupant[target];
+                    position[0] = target;
+                    if (moved > 0) position[moved] = blank;
+                    uint64_t child = ranker.rank(position);
+                    position[0] = blank;
+                    if (moved > 0) position[moved] = target;
+
+                    uint8_t expected = DISTANCE_UNREACHED;
+                    if (__atomic_compare_exchange_n(&table[child], &expected, (uint8_t)(level + 1), false,
+                                                    __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                        added++;
+                }
+            }
+
+            #pragma omp single
+            {
+                if (added == 0) {
+                    done = true;
+                } else if (level + 1 == DISTANCE_UNREACHED - 1) {
+                    done = overflow = true;
+                } else {
+                    level++;
+                    reachable += added;
+                    cout << "Nivel " << level << ": " << added << " estados" << endl;
+                    added = 0;
+                }
+            }
+        }
+    }
+    return overflow ? -1 : level;
+}
+
+int query(const string& path, int count, char* boards[]) {
+    try {
+        DistanceTable table(path);
+        const DistanceTableShape& shape = table.shape();
+        for (int i = 0; i < count; i++) {
+            vector<uint16_t> tiles;
+            string error;
+            if (!parseTileList(boards[i], shape.cells(), tiles, error)) {
+                cerr << "Error: tablero no válido " << boards[i] << ": " << error << endl;
+                return 1;
+            }
+            int distance = table.distance(tiles);
+            if (distance == DISTANCE_UNREACHED) cout << boards[i] << " inalcanzable" << endl;
+            else cout << boards[i] << " " << distance << endl;
+        }
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    const string usage = string("Uso: ") + argv[0] +
+        " <filas>x<columnas> <salida.pdt> [--goal <tablero>] [--tiles <fichas>] [--bind none|compact|spread] [--sockets <n>]"
+        " | --query <tabla.pdt> <tablero>...";
+    if (argc >= 4 && string(argv[1]) == "--query") return query(argv[2], argc - 3, argv + 3);
+    if (argc < 3) {
+        cerr << usage << endl;
+        return 1;
+    }
+
+    DistanceTableShape shape;
+    string dims = argv[1];
+    if (dims.find('x') == string::npos || sscanf(dims.c_str(), "%dx%d", &shape.rows, &shape.cols) != 2 ||
+        shape.rows < 1 || shape.cols < 1 || shape.cells() < 2 || shape.cells() > DISTANCE_TABLE_MAX_CELLS) {
+        cerr << "Error: tamaño no válido '" << dims << "' (máximo " << DISTANCE_TABLE_MAX_CELLS << " casillas)" << endl;
+        return 1;
+    }
+    const int cells = shape.cells();
+    string outputPath = argv[2];
+    string goalText, tilesText;
+    PlacementOptions placement;
+    for (int i = 3; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--goal" && i + 1 < argc) goalText = argv[++i];
+        else if (arg == "--tiles" && i + 1 < argc) tilesText = argv[++i];
+        else if (!parsePlacementOption(i, argc, argv, placement)) {
+            cerr << usage << endl;
+            return 1;
+        }
+    }
+
+    string error;
+    if (goalText.empty()) {
+        for (int i = 1; i < cells; i++) shape.goal.push_back((uint16_t)i);
+        shape.goal.push_back(BLANK_TILE);
+    } else if (!parseTileList(goalText, cells, shape.goal, error)) {
+        cerr << "Error: objetivo no válido: " << error << endl;
+        return 1;
+    }
+    if (tilesText.empty()) {
+        for (int i = 1; i < cells; i++) shape.pattern.push_back((uint16_t)i);
+    } else if (!parsePattern(tilesText, cells, shape.pattern, error)) {
+        cerr << "Error: " << error << endl;
+        return 1;
+    }
+    // The last tile of a full pattern is implied by the others.
+    if ((int)shape.pattern.size() == cells - 1) shape.pattern.pop_back();
+
+    uint64_t entries = PlacementRanker(cells, shape.objects()).size();
+    if (entries > MAX_TABLE_ENTRIES) {
+        cerr << "Error: la tabla tendría " << entries << " entradas (máximo " << MAX_TABLE_ENTRIES << "); use menos fichas" << endl;
+        return 1;
+    }
+
+    threadPlacement = ThreadPlacement(placement);
+    cout << "Tabla " << shape.rows << "x" << shape.cols << ", " << shape.pattern.size() << " fichas de patrón, "
+         << entries << " entradas, " << omp_get_max_threads() << " hilos" << endl;
+    if (threadPlacement.enabled()) cout << "Hilos: " << threadPlacement.describe() << endl;
+
+    vector<uint8_t> distances;
+    uint64_t reachable = 0;
+    double start = omp_get_wtime();
+    int largest = buildTable(shape, distances, reachable);
+    double seconds = omp_get_wtime() - start;
+    if (largest < 0) {
+        cerr << "Error: distancias mayores que " << DISTANCE_UNREACHED - 2 << "; no caben en un byte" << endl;
+        return 1;
+    }
+
+    try {
+        writeDistanceTable(outputPath, shape, distances.data(), entries, reachable, largest);
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+    cout << "Estados alcanzables: " << reachable << ", distancia máxima: " << largest << endl;
+    cout << "Tiempo de construcción: " << seconds << " segundos." << endl;
+    cout << "Tabla escrita en " << outputPath << endl;
+    return 0;
+}
@@ -0,0 +1,199 @@
+/**
+ * @file distance_table.h
+ * @brief Exact distance tables (full state spaces or tile patterns) and their file format
+ *
+ * A table stores, for every placement of the blank and a chosen set of
+ * tiles (the pattern), the exact number of moves to the goal placement when
+ * the other tiles are indistinguishable. With every tile in the pattern it
+ * is the exact distance of every board (2x3, 2x4, 3x3); with a subset of
+ * the 4x4 tiles it is a pattern database, an admissible heuristic.
+ *
+ * A placement is the list of cells of its objects (object 0 the blank,
+ * object i the i-th pattern tile) and is ranked as a partial permutation:
+ * digit i is the cell of object i among the cells not used by objects
+ * 0..i-1, read in base cells - i. The ranks are dense, 0 to
+ * cells! / (cells - objects)! - 1, so the table is a plain byte array.
+ *
+ * Layout (little endian):
+ *   offset  0  char[4]  magic "PZDT"
+ *   offset  4  uint16   format version (1)
+ *   offset  6  uint8    rows
+ *   offset  7  uint8    columns
+ *   offset  8  uint8    pattern tiles (k)
+ *   offset  9  uint8    largest distance
+ *   offset 10  uint8[6] reserved, zero
+ *   offset 16  uint64   number of entries
+ *   offset 24  uint64   reachable entries
+ *   offset 32  uint8[rows * columns]  goal tile IDs, row-major
+ *   then       uint8[k]               pattern tile IDs, in object order
+ *   then       uint8[entries]         distance per rank, 255 = unreachable
+ */
+#ifndef DISTANCE_TABLE_H
+#define DISTANCE_TABLE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "puzzle_tiles.h"
+
+const char DISTANCE_TABLE_MAGIC[4] = {'P', 'Z', 'D', 'T'};
+const uint16_t DISTANCE_TABLE_VERSION = 1;
+const size_t DISTANCE_TABLE_HEADER_BYTES = 32;
+const uint8_t DISTANCE_UNREACHED = 255;
+const int DISTANCE_TABLE_MAX_CELLS = 16;
+
+/**
+ * @brief Dense ranking of the cells of `objects` distinct objects on a board of `cells` cells
+ */
+class PlacementRanker {
+public:
+    PlacementRanker(int cells, int objects) : cells_(cells), objects_(objects) {
+        for (int i = 0; i < objects; i++) size_ *= (uint64_t)(cells - i);
+    }
+
+    uint64_t size() const { return size_; }
+
+    uint64_t rank(const int* position) const {
+        uint32_t used = 0;
+        uint64_t rank = 0;
+        for (int i = 0; i < objects_; i++) {
+            int smaller = position[i] - __builtin_popcount(used & ((1u << position[i]) - 1));
+            rank = rank * (uint64_t)(cells_ - i) + (uint64_t)smaller;
+            used |= 1u << position[i];
+        }
+        return rank;
+    }
+
+    void unrank(uint64_t rank, int* position) const {
+        int digit[DISTANCE_TABLE_MAX_CELLS];
+        for (int i = objects_ - 1; i >= 0; i--) {
+            digit[i] = (int)(rank % (uint64_t)(cells_ - i));
+            rank /= (uint64_t)(cells_ - i);
+        }
+        uint32_t used = 0;
+        for (int i = 0; i < objects_; i++) {
+            int cell = 0;
+            for (int skip = digit[i];; cell++) {
+                if (used & (1u << cell)) continue;
+                if (skip-- == 0) break;
+            }
+            position[i] = cell;
+            used |= 1u << cell;
+        }
+    }
+
+private:
+    int cells_;
+    int objects_;
+    uint64_t size_ = 1;
+};
+
+/**
+ * @brief Description of a table: board shape, goal and pattern tiles
+ */
+struct DistanceTableShape {
+    int rows = 0;
+    int cols = 0;
+    std::vector<uint16_t> goal;     // tile IDs, row-major
+    std::vector<uint16_t> pattern;  // tile IDs of objects 1..k
+
+    int cells() const { return rows * cols; }
+    int objects() const { return (int)pattern.size() + 1; }
+
+    /**
+     * @brief Object cells of a full board: the blank first, then the pattern tiles
+     */
+    void placement(const std::vector<uint16_t>& tiles, int* position) const {
+        for (int cell = 0; cell < cells(); cell++) {
+            if (tiles[cell] == BLANK_TILE) position[0] = cell;
+        }
+        for (size_t i = 0; i < pattern.size(); i++) {
+            for (int cell = 0; cell < cells(); cell++) {
+                if (tiles[cell] == pattern[i]) position[i + 1] = cell;
+            }
+        }
+    }
+};
+
+inline void writeDistanceTable(const std::string& path, const DistanceTableShape& shape, const uint8_t* distances,
+                               uint64_t entries, uint64_t reachable, int largest) {
+    std::ofstream out(path, std::ios::binary);
+    if (!out) throw std::runtime_error("no se pudo crear " + path);
+    uint8_t header[DISTANCE_TABLE_HEADER_BYTES] = {0};
+    memcpy(header, DISTANCE_TABLE_MAGIC, 4);
+    memcpy(header + 4, &DISTANCE_TABLE_VERSION, 2);
+    header[6] = (uint8_t)shape.rows;
+    header[7] = (uint8_t)shape.cols;
+    header[8] = (uint8_t)shape.pattern.size();
+    header[9] = (uint8_t)largest;
+    memcpy(header + 16, &entries, 8);
+    memcpy(header + 24, &reachable, 8);
+    out.write((const char*)header, sizeof(header));
+    for (uint16_t tile : shape.goal) out.put((char)tile);
+    for (uint16_t tile : shape.pattern) out.put((char)tile);
+    const uint64_t chunk = 1 << 24;
+    for (uint64_t offset = 0; offset < entries; offset += chunk)
+        out.write((const char*)distances + offset, (std::streamsize)std::min(chunk, entries - offset));
+    if (!out) throw std::runtime_error("error al escribir " + path);
+}
+
+/**
+ * @brief A table loaded in memory; distance() looks boards up by their pattern placement
+ */
+class DistanceTable {
+public:
+    explicit DistanceTable(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) throw std::runtime_error("no se pudo abrir " + path);
+        uint8_t header[DISTANCE_TABLE_HEADER_BYTES];
+        uint16_t version = 0;
+        uint64_t entries = 0;
+        in.read((char*)header, sizeof(header));
+        memcpy(&version, header + 4, 2);
+        memcpy(&entries, header + 16, 8);
+        memcpy(&reachable_, header + 24, 8);
+        shape_.rows = header[6];
+        shape_.cols = header[7];
+        largest_ = header[9];
+        int cells = shape_.cells();
+        if (!in || memcmp(header, DISTANCE_TABLE_MAGIC, 4) != 0 || version != DISTANCE_TABLE_VERSION ||
+            cells < 2 || cells > DISTANCE_TABLE_MAX_CELLS || header[8] >= cells)
+            throw std::runtime_error(path + " no es una tabla de distancias válida");
+        shape_.goal.resize(cells);
+        shape_.pattern.resize(header[8]);
+        for (uint16_t& tile : shape_.goal) tile = (uint16_t)in.get();
+        for (uint16_t& tile : shape_.pattern) tile = (uint16_t)in.get();
+        ranker_ = PlacementRanker(cells, shape_.objects());
+        if (entries != ranker_.size()) throw std::runtime_error(path + " no es una tabla de distancias válida");
+        distances_.resize(entries);
+        in.read((char*)distances_.data(), (std::streamsize)entries);
+        if (!in) throw std::runtime_error(path + " está truncado");
+    }
+
+    const DistanceTableShape& shape() const { return shape_; }
+    uint64_t entries() const { return distances_.size(); }
+    uint64_t reachable() const { return reachable_; }
+    int largest() const { return largest_; }
+
+    /**
+     * @brief Distance of a board of the table's shape, DISTANCE_UNREACHED if it cannot reach the goal
+     */
+    int distance(const std::vector<uint16_t>& tiles) const {
+        int position[DISTANCE_TABLE_MAX_CELLS];
+        shape_.placement(tiles, position);
+        return distances_[ranker_.rank(position)];
+    }
+
+private:
+    DistanceTableShape shape_;
+    PlacementRanker ranker_{2, 1};
+    std::vector<uint8_t> distances_;
+    uint64_t reachable_ = 0;
+    int largest_ = 0;
+};
+
+#endif
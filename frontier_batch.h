@@ -0,0 +1,178 @@
+/**
+ * @file frontier_batch.h
+ * @brief Structure-of-arrays frontiers of packed 4x4 boards for batch expansion
+ *
+ * The batched OpenMP A* engines used to carry every node as a std::string
+ * (16 letters, one past the small-string buffer, so one heap block per node)
+ * plus its ints, and copied those objects between the heap, the batch and the
+ * per-thread arenas. Here a 4x4 board is one uint64 (tile IDs in nibbles,
+ * cell 0 in the low nibble, as packBoard16) and a frontier is four parallel
+ * arrays: boards, blank cells, g and h.
+ *
+ * BatchExpander generates the four children of a run of parents in one pass
+ * over flat arrays: each child slot is filled with the same table lookups,
+ * shifts and masks whether or not the move is legal, and a separate mask
+ * array says which slots are real. The heuristic must be a sum of per-tile
+ * terms (misplaced tiles and Manhattan distance both are), so a child's h is
+ * its parent's plus one table difference for the tile that moved.
+ *
+ * The shared heap holds FrontierNode, a flat 24-byte record ordered like
+ * AStarState (f, then larger g first).
+ */
+#ifndef FRONTIER_BATCH_H
+#define FRONTIER_BATCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "move_table.h"
+
+/**
+ * @brief Packs a 4x4 letter board ("ABC...#") one tile ID per nibble
+ */
+inline uint64_t packLetters16(const std::string& board) {
+    uint64_t packed = 0;
+    for (int i = 0; i < 16; i++) {
+        uint64_t tile = board[i] == '#' ? 0 : (uint64_t)(board[i] - 'A' + 1);
+        packed |= (tile & 0xF) << (4 * i);
+    }
+    return packed;
+}
+
+struct FrontierBatch {
+    std::vector<uint64_t> board;
+    std::vector<uint8_t> blank;
+    std::vector<uint16_t> cost;
+    std::vector<uint16_t> heuristic;
+
+    size_t size() const { return board.size(); }
+
+    void clear() {
+        board.clear();
+        blank.clear();
+        cost.clear();
+        heuristic.clear();
+    }
+
+    void reserve(size_t n) {
+        board.reserve(n);
+        blank.reserve(n);
+        cost.reserve(n);
+        heuristic.reserve(n);
+    }
+
+    void push(uint64_t b, int pos, int g, int h) {
+        board.push_back(b);
+        blank.push_back((uint8_t)pos);
+        cost.push_back((uint16_t)g);
+        heuristic.push_back((uint16_t)h);
+    }
+};
+
+/**
+ * @brief Open-list entry of the shared heap
+ */
+struct FrontierNode {
+    uint64_t board;
+    double f;
+    uint16_t cost;
+    uint16_t heuristic;
+    uint8_t blank;
+
+    FrontierNode() = default;
+    FrontierNode(uint64_t b, int pos, int g, int h, double w)
+        : board(b), f(g + w * h), cost((uint16_t)g), heuristic((uint16_t)h), blank((uint8_t)pos) {}
+
+    bool operator>(const FrontierNode& other) const {
+        if (f != other.f) return f > other.f;
+        return cost < other.cost;
+    }
+};
+
+/**
+ * @brief Approximate bytes per stored state: heap entry plus unordered_map<uint64_t, uint16_t> node and bucket
+ */
+const size_t FRONTIER_STATE_BYTES = sizeof(FrontierNode) + 2 * sizeof(uint64_t) + 3 * sizeof(void*);
+
+class BatchExpander {
+public:
+    /**
+     * @brief `score(tile, cell)` is the heuristic term of `tile` standing on `cell`
+     */
+    template <class Score>
+    explicit BatchExpander(Score score) {
+        MoveTable moves(4);
+        for (int cell = 0; cell < 16; cell++) {
+            for (int move = 0; move < 4; move++) {
+                int next = moves.target(cell, move);
+                target_[4 * cell + move] = (uint8_t)(next < 0 ? cell : next);
+                legal_[4 * cell + move] = next >= 0;
+            }
+        }
+        for (int tile = 0; tile < 16; tile++) {
+            for (int from = 0; from < 16; from++) {
+                for (int to = 0; to < 16; to++)
+                    delta_[(tile * 16 + from) * 16 + to] = (int8_t)(tile == 0 ? 0 : score(tile, to) - score(tile, from));
+            }
+        }
+    }
+
+    /**
+     * @brief Heuristic of a whole packed board
+     */
+    template <class Score>
+    static int evaluate(uint64_t board, Score score) {
+        int h = 0;
+        for (int cell = 0; cell < 16; cell++) {
+            int tile = (int)((board >> (4 * cell)) & 0xF);
+            if (tile != 0) h += score(tile, cell);
+        }
+        return h;
+    }
+
+    /**
+     * @brief Writes the 4 child slots of parents [begin, end) to `children`, legal[k] = 1 for real moves
+     *
+     * Slot 4 * (i - begin) + m is the child of parent i by move m (MOVE_* order).
+     */
+    void expand(const FrontierBatch& parents, size_t begin, size_t end, FrontierBatch& children,
+                std::vector<uint8_t>& legal) const {
+        const size_t slots = 4 * (end - begin);
+        children.board.resize(slots);
+        children.blank.resize(slots);
+        children.cost.resize(slots);
+        children.heuristic.resize(slots);
+        legal.resize(slots);
+
+        const uint64_t* board = parents.board.data() + begin;
+        const uint8_t* blank = parents.blank.data() + begin;
+        const uint16_t* cost = parents.cost.data() + begin;
+        const uint16_t* heuristic = parents.heuristic.data() + begin;
+        uint64_t* childBoard = children.board.data();
+        uint8_t* childBlank = children.blank.data();
+        uint16_t* childCost = children.cost.data();
+        uint16_t* childHeuristic = children.heuristic.data();
+        uint8_t* childLegal = legal.data();
+
+        for (size_t k = 0; k < slots; k++) {
+            size_t i = k >> 2;
+            int from = blank[i];
+            int to = target_[4 * from + (k & 3)];
+            uint64_t tile = (board[i] >> (4 * to)) & 0xF;
+            childBoard[k] = (board[i] & ~(0xFULL << (4 * to))) | (tile << (4 * from));
+            childBlank[k] = (uint8_t)to;
+            childCost[k] = (uint16_t)(cost[i] + 1);
+            // The tile moves from `to` into the blank's old cell `from`.
+            childHeuristic[k] = (uint16_t)(heuristic[i] + delta_[(tile * 16 + to) * 16 + from]);
+            childLegal[k] = legal_[4 * from + (k & 3)];
+        }
+    }
+
+private:
+    uint8_t target_[64];
+    uint8_t legal_[64];
+    int8_t delta_[16 * 16 * 16];
+};
+
+#endif
@@ -0,0 +1,158 @@
+/**
+ * @file goal_relabel.h
+ * @brief Solving towards any goal by relabeling it onto the canonical one
+ *
+ * The solvers and everything they precompute (Manhattan and pattern tables,
+ * move deltas, the h2 perimeter, distance tables, the server cache) are
+ * built for the canonical goal: tile k in cell k - 1, blank last. A custom
+ * goal does not get its own tables; the (start, goal) pair is rewritten into
+ * an equivalent pair whose goal is canonical, using two changes that keep
+ * every path and its length:
+ *  - a symmetry of the square (rotation or reflection), which maps cells to
+ *    cells and blank moves to blank moves;
+ *  - renaming tiles: the goal's tile in cell i becomes the canonical tile of
+ *    cell i, in the goal and in the start alike.
+ * Renaming cannot move the blank, so the symmetry brings the goal's blank as
+ * close as it can to the bottom-right corner. A goal with the blank in any
+ * corner becomes exactly the canonical goal. Otherwise the blank lands on
+ * cell b and the goal becomes the canonical goal with the blank slid from
+ * the corner to b, up the last column and then left along the row
+ * (canonicalGoalTiles(side, b)): one of a handful of layouts per size
+ * instead of one per goal.
+ *
+ * Moves found for the relabeled pair are mapped back to the caller's board
+ * with userMove().
+ */
+#ifndef GOAL_RELABEL_H
+#define GOAL_RELABEL_H
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "puzzle_tiles.h"
+
+/**
+ * @brief Canonical goal with the blank slid from the last cell to `blankCell`
+ */
+inline std::vector<uint16_t> canonicalGoalTiles(int side, int blankCell) {
+    std::vector<uint16_t> goal = canonicalGoalTiles(side);
+    int blank = side * side - 1;
+    while (blank / side > blankCell / side) {
+        std::swap(goal[blank], goal[blank - side]);
+        blank -= side;
+    }
+    while (blank % side > blankCell % side) {
+        std::swap(goal[blank], goal[blank - 1]);
+        blank--;
+    }
+    return goal;
+}
+
+class GoalRelabeling {
+public:
+    /**
+     * @brief No custom goal: boards are solved as given
+     */
+    GoalRelabeling() = default;
+
+    /**
+     * @brief Relabeling of `goal`, a permutation of 0..side*side-1 (see parseTiles)
+     */
+    GoalRelabeling(const std::vector<uint16_t>& goal, int side) : side_(side) {
+        const int cells = side * side;
+        int goalBlank = blankPosition(goal);
+
+        // Closest image of the blank to the last cell; ties go to the larger cell, so
+        // goals whose blanks are symmetric to each other get the same layout.
+        int bestDistance = 2 * side, bestCell = -1;
+        for (int symmetry = 0; symmetry < 8; symmetry++) {
+            int cell = mapCell(goalBlank, symmetry);
+            int distance = 2 * (side - 1) - cell / side - cell % side;
+            if (distance < bestDistance || (distance == bestDistance && cell > bestCell)) {
+                bestDistance = distance;
+                bestCell = cell;
+                symmetry_ = symmetry;
+            }
+        }
+
+        goal_ = canonicalGoalTiles(side, bestCell);
+        cellMap_.resize(cells);
+        std::vector<uint16_t> moved(cells);
+        for (int cell = 0; cell < cells; cell++) {
+            cellMap_[cell] = mapCell(cell, symmetry_);
+            moved[cellMap_[cell]] = goal[cell];
+        }
+        label_.resize(cells);
+        for (int cell = 0; cell < cells; cell++) label_[moved[cell]] = goal_[cell];
+
+        const int dRow[] = {-1, 1, 0, 0};
+        const int dCol[] = {0, 0, -1, 1};
+        for (int move = 0; move < 4; move++) {
+            int row = dRow[move], col = dCol[move];
+            if (symmetry_ & 4) std::swap(row, col);
+            if (symmetry_ & 2) row = -row;
+            if (symmetry_ & 1) col = -col;
+            int image = row < 0 ? 0 : row > 0 ? 1 : col < 0 ? 2 : 3;
+            userMove_[image] = move;
+        }
+
+        identity_ = symmetry_ == 0;
+        for (int tile = 0; tile < cells; tile++) identity_ = identity_ && label_[tile] == tile;
+    }
+
+    /**
+     * @brief True when boards need no rewriting (no custom goal, or the canonical one)
+     */
+    bool identity() const { return identity_; }
+
+    /**
+     * @brief The goal the solvers search for: canonical, or canonical with the blank slid to blankCell()
+     */
+    const std::vector<uint16_t>& goal() const { return goal_; }
+
+    int blankCell() const { return blankPosition(goal_); }
+
+    /**
+     * @brief A start board in the relabeled frame
+     */
+    std::vector<uint16_t> apply(const std::vector<uint16_t>& tiles) const {
+        if (identity_) return tiles;
+        std::vector<uint16_t> out(tiles.size());
+        for (size_t cell = 0; cell < tiles.size(); cell++) out[cellMap_[cell]] = label_[tiles[cell]];
+        return out;
+    }
+
+    /**
+     * @brief The caller's move (MOVE_* order) for a move found in the relabeled frame
+     */
+    int userMove(int move) const { return identity_ || move < 0 ? move : userMove_[move]; }
+
+    std::vector<int> userMoves(const std::vector<int>& moves) const {
+        std::vector<int> out;
+        out.reserve(moves.size());
+        for (int move : moves) out.push_back(userMove(move));
+        return out;
+    }
+
+private:
+    /**
+     * @brief Image of a cell: bit 2 transposes, then bit 1 flips rows and bit 0 flips columns
+     */
+    int mapCell(int cell, int symmetry) const {
+        int row = cell / side_, col = cell % side_;
+        if (symmetry & 4) std::swap(row, col);
+        if (symmetry & 2) row = side_ - 1 - row;
+        if (symmetry & 1) col = side_ - 1 - col;
+        return row * side_ + col;
+    }
+
+    int side_ = 0;
+    int symmetry_ = 0;
+    bool identity_ = true;
+    std::vector<uint16_t> goal_;
+    std::vector<int> cellMap_;
+    std::vector<uint16_t> label_;
+    int userMove_[4] = {0, 1, 2, 3};
+};
+
+#endif
@@ -6,7 +6,8 @@
  * of moves required to reach the goal state from the initial state.
  * 
  * Goal state: "ABCDEFGHIJKLMNO#"
- * Where '#' represents the empty space.
+ * Where '#' represents the empty space. --goal <tablero> solves towards
+ * another board instead (see goal_relabel.h).
  * 
  * @author JAPeTo
  * @version 1.6
@@ -15,26 +16,47 @@
 #include <iostream>
 #include <fstream>
 #include <queue>
-#include <unordered_set>
+#include <unordered_map>
 #include <vector>
 #include <functional>
+#include <atomic>
+#include <climits>
+#include <thread>
 #include <omp.h>
+#include "search_budget.h"
+#include "result_writer.h"
+#include "puzzle_set.h"
+#include "multi_queue.h"
+#include "thread_placement.h"
+#include "search_checkpoint.h"
+#include "goal_relabel.h"
+#include "frontier_batch.h"
 
 using namespace std;
 
-const string TARGET = "ABCDEFGHIJKLMNO#";
+string TARGET = "ABCDEFGHIJKLMNO#";  // replaced by the relabeled --goal (see goal_relabel.h)
+SearchBudget searchBudget;
+CheckpointOptions checkpointOptions;
+bool verboseOutput = true;
+ThreadPlacement threadPlacement{PlacementOptions()};
 
+/**
+ * @brief Search node ordered by f = g + w*h (w = 1.0 is plain A*)
+ */
 struct AStarState {
     string board;
     int blankPos;
     int cost;
     int heuristic;
+    double f;
 
-    AStarState(string b, int pos, int c, int h)
-        : board(b), blankPos(pos), cost(c), heuristic(h) {}
+    AStarState() = default;
+    AStarState(const string& b, int pos, int c, int h, double w = 1.0)
+        : board(b), blankPos(pos), cost(c), heuristic(h), f(c + w * h) {}
 
     bool operator>(const AStarState& other) const {
-        return (cost + heuristic) > (other.cost + other.heuristic);
+        if (f != other.f) return f > other.f;
+        return cost < other.cost;
     }
 };
 
@@ -57,111 +79,372 @@ int h1_heuristic(const string& board) {
     return misplaced;
 }
 
-int parallel_aStarSearch(string start) {
-    priority_queue<AStarState, vector<AStarState>, greater<AStarState>> pq;
-    unordered_set<string> visited;
+/**
+ * @brief Per-tile term of h1_heuristic: 1 when `tile` standing on `cell` is misplaced
+ */
+int h1_score(int tile, int cell) {
+    return TARGET[cell] != (char)('A' + tile - 1);
+}
 
-    int blankPos = -1;
-    for (int i = 0; i < 16; i++) {
-        if (start[i] == '#') {
-            blankPos = i;
-            break;
+/**
+ * @brief Batched parallel A* run by one persistent thread team
+ *
+ * One worker pops a batch of the best 2 * threads nodes, the team expands it
+ * and each worker keeps the children it generates in its own arena; the next
+ * batch starts by pushing the arenas into the shared heap. The team lives for
+ * the whole search and each worker pins itself (see thread_placement.h), so
+ * the arenas stay on the worker's NUMA node and only the heap is shared.
+ *
+ * Boards are packed in a uint64 and the batch and arenas are
+ * structure-of-arrays frontiers (see frontier_batch.h): each worker expands
+ * its slice of the batch in one flat pass and checks all its children
+ * against the cost table under a single lock.
+ *
+ * A batch is only roughly in f order, so a board may first be reached
+ * through a longer path. The best g of every board is kept in a table: a
+ * child reached more cheaply is pushed again and a heap entry whose g is no
+ * longer the best is dropped. Reaching the goal only lowers the incumbent;
+ * the search ends when the best f left in the heap is not below it, so with
+ * w = 1 the returned cost is optimal.
+ *
+ * With --checkpoint a snapshot (see search_checkpoint.h) is taken when the
+ * arenas have been pushed and no batch is out: the heap, the cost table and
+ * the counter, none of it tied to a thread.
+ */
+int parallel_aStarSearch(const string& start, double weight = 1.0, SearchStats* stats = nullptr) {
+    static const BatchExpander expander(h1_score);
+    priority_queue<FrontierNode, vector<FrontierNode>, greater<FrontierNode>> pq;
+    unordered_map<uint64_t, uint16_t> costs;
+    BudgetGuard guard(searchBudget, FRONTIER_STATE_BYTES);
+    SearchCheckpoint checkpoint(checkpointOptions, "h1_omp", "w=" + to_string(weight) + " g=" + to_string(TARGET.find('#')), start);
+    long long expandedNodes = 0;
+
+    const uint64_t target = packLetters16(TARGET);
+    bool resumed = checkpoint.resume([&](SnapshotReader& in) {
+        expandedNodes = in.get<int64_t>();
+        uint64_t count = in.get<uint64_t>();
+        vector<FrontierNode>& open = adaptorContainer(pq);
+        for (uint64_t i = 0; i < count; i++) {
+            uint64_t board = in.get<uint64_t>();
+            int blank = in.get<uint8_t>();
+            int cost = in.get<uint16_t>();
+            int heuristic = in.get<uint16_t>();
+            open.push_back(FrontierNode(board, blank, cost, heuristic, weight));
         }
+        count = in.get<uint64_t>();
+        if (count > in.left() / (sizeof(uint64_t) + sizeof(uint16_t))) throw runtime_error("lista cerrada no válida");
+        costs.reserve(count);
+        for (uint64_t i = 0; i < count; i++) {
+            uint64_t board = in.get<uint64_t>();
+            costs[board] = in.get<uint16_t>();
+        }
+    });
+    if (resumed) {
+        if (verboseOutput) cout << "Reanudando desde " << checkpoint.path() << ": " << expandedNodes
+                                << " nodos expandidos, " << costs.size() << " estados visitados" << endl;
+    } else {
+        expandedNodes = 0;
+        pq = priority_queue<FrontierNode, vector<FrontierNode>, greater<FrontierNode>>();
+        costs.clear();
+        uint64_t startBoard = packLetters16(start);
+        pq.push(FrontierNode(startBoard, (int)start.find('#'), 0, BatchExpander::evaluate(startBoard, h1_score), weight));
+        costs[startBoard] = 0;
     }
 
-    int initialHeuristic = h1_heuristic(start);
-    pq.push(AStarState(start, blankPos, 0, initialHeuristic));
-    visited.insert(start);
-
-    bool solution_found = false;
-    int solution_cost = -1;
+    auto saveSnapshot = [&]() {
+        return checkpoint.save([&](SnapshotWriter& out) {
+            const vector<FrontierNode>& open = adaptorContainer(pq);
+            out.put<int64_t>(expandedNodes);
+            out.put<uint64_t>(open.size());
+            for (const FrontierNode& node : open) {
+                out.put<uint64_t>(node.board);
+                out.put<uint8_t>(node.blank);
+                out.put<uint16_t>(node.cost);
+                out.put<uint16_t>(node.heuristic);
+            }
+            out.put<uint64_t>(costs.size());
+            for (const auto& entry : costs) {
+                out.put<uint64_t>(entry.first);
+                out.put<uint16_t>(entry.second);
+            }
+        });
+    };
 
-    while (!pq.empty() && !solution_found) {
-        vector<AStarState> best_states;
-        int batch_size = min((int)pq.size(), omp_get_max_threads() * 2);
+    // The goal's entry in the cost table is the incumbent, so a resumed search keeps it.
+    auto goalCost = costs.find(target);
+    int incumbent = goalCost == costs.end() ? INT_MAX : goalCost->second;
+    auto stale = [&](const FrontierNode& node) { return costs[node.board] < node.cost; };
 
-        for (int i = 0; i < batch_size && !pq.empty(); i++) {
-            best_states.push_back(pq.top());
-            pq.pop();
-        }
+    int threads = max(1, omp_get_max_threads());
+    vector<FrontierBatch> arenas(threads);
+    FrontierBatch batch;
+    batch.reserve(threads * 2);
+    bool done = false;
+    bool proven = false;
+    bool saved = false;
+    bool interrupted = false;
 
-        vector<AStarState> new_states;
+    #pragma omp parallel num_threads(threads)
+    {
+        int thread = omp_get_thread_num();
+        threadPlacement.pin(thread);
+        FrontierBatch& local_new = arenas[thread];
+        FrontierBatch children;
+        vector<uint8_t> legal;
+        local_new.reserve(32);
 
-        #pragma omp parallel
-        {
-            vector<AStarState> local_new_states;
+        while (true) {
+            #pragma omp single
+            {
+                for (auto& arena : arenas) {
+                    for (size_t i = 0; i < arena.size(); i++)
+                        pq.push(FrontierNode(arena.board[i], arena.blank[i], arena.cost[i], arena.heuristic[i], weight));
+                    arena.clear();
+                }
+                while (!pq.empty() && stale(pq.top())) pq.pop();
+                proven = pq.empty() || pq.top().f >= incumbent;
+                done = proven || guard.overLimits(expandedNodes, costs.size()) || guard.timeUp();
+                if (!proven && (checkpoint.due() || (done && checkpoint.enabled()))) {
+                    saved = saveSnapshot();
+                    interrupted = checkpoint.interrupted();
+                    done = done || interrupted;
+                }
+                batch.clear();
+                while (!done && batch.size() < (size_t)threads * 2 && !pq.empty() && pq.top().f < incumbent) {
+                    const FrontierNode& top = pq.top();
+                    if (!stale(top)) batch.push(top.board, top.blank, top.cost, top.heuristic);
+                    pq.pop();
+                }
+                expandedNodes += batch.size();
+            }
+            if (done) break;
 
-            #pragma omp for
-            for (int i = 0; i < batch_size; i++) {
-                AStarState current = best_states[i];
+            size_t begin = batch.size() * thread / threads;
+            size_t end = batch.size() * (thread + 1) / threads;
 
-                if (!solution_found && current.board == TARGET) {
-                    #pragma omp critical
-                    {
-                        if (!solution_found) {
-                            solution_found = true;
-                            solution_cost = current.cost;
-                        }
+            // A batch is expanded whole even if the budget trips meanwhile, so
+            // the heap and cost table stay consistent for a snapshot.
+            if (begin < end) {
+                expander.expand(batch, begin, end, children, legal);
+                #pragma omp critical (visited_access)
+                {
+                    for (size_t k = 0; k < children.size(); ++k) {
+                        if (!legal[k] || children.cost[k] + children.heuristic[k] >= incumbent) continue;
+                        auto it = costs.find(children.board[k]);
+                        if (it != costs.end() && it->second <= children.cost[k]) continue;
+                        costs[children.board[k]] = children.cost[k];
+                        if (children.board[k] == target) incumbent = children.cost[k];
+                        else local_new.push(children.board[k], children.blank[k], children.cost[k], children.heuristic[k]);
                     }
+                    guard.overLimits(0, costs.size());
                 }
+            }
+            #pragma omp barrier
+        }
+    }
 
-                if (solution_found) continue; 
+    if (stats) *stats = {expandedNodes, costs.size()};
+    if (interrupted) {
+        if (verboseOutput) cout << "Búsqueda interrumpida; instantánea en " << checkpoint.path() << endl;
+        return BUDGET_EXCEEDED;
+    }
+    if (!proven) {
+        if (verboseOutput) {
+            cout << "Presupuesto excedido (" << guard.reasonText() << ")" << endl;
+            cout << "Nodos expandidos: " << expandedNodes << endl;
+            cout << "Estados visitados: " << costs.size() << endl;
+            if (!pq.empty()) cout << "Mejor f en la frontera: " << pq.top().cost + pq.top().heuristic << endl;
+            if (saved) cout << "Instantánea en " << checkpoint.path() << endl;
+        }
+        return BUDGET_EXCEEDED;
+    }
+    checkpoint.discard();
+    return incumbent == INT_MAX ? -1 : incumbent;
+}
+
+/**
+ * @brief Parallel best-first search over a MultiQueue, without batch barriers
+ *
+ * Every thread pops a near-minimal node, expands it and pushes its children
+ * straight back; there is no shared heap and no merge step. Because pops are
+ * only approximately ordered, a node may first be reached through a longer
+ * path: the best g of every board lives in a sharded table, a child reached
+ * more cheaply is reopened and a popped node whose g is no longer the best
+ * is dropped.
+ *
+ * Reaching the goal only lowers the incumbent. Nodes with g + h >= incumbent
+ * are pruned, which h allows because it never overestimates, and the search
+ * ends when the queue is empty and no thread holds a node. Whatever the
+ * weight, the returned cost is then optimal; w only changes the pop order.
+ */
+int multiQueue_aStarSearch(const string& start, double weight = 1.0, SearchStats* stats = nullptr) {
+    int threads = max(1, omp_get_max_threads());
+    auto fKey = [](const AStarState& s) { return s.f; };
+    MultiQueue<AStarState, greater<AStarState>, decltype(fKey)> open(threads, 4, fKey);
+    ShardedCostTable costs(64 * threads);
+    BudgetGuard guard(searchBudget, estimatedStateBytes(start.size()));
+    atomic<long long> expandedNodes(0);
+    atomic<int> incumbent(INT_MAX);
+    atomic<int> active(0);
+
+    auto offer = [&](int cost) {
+        int best = incumbent.load();
+        while (cost < best && !incumbent.compare_exchange_weak(best, cost)) {}
+    };
+
+    QueueRandom startRandom(1);
+    costs.improve(start, 0);
+    if (start == TARGET) offer(0);
+    else open.push(AStarState(start, (int)start.find('#'), 0, h1_heuristic(start), weight), startRandom);
+
+    #pragma omp parallel num_threads(threads)
+    {
+        threadPlacement.pin(omp_get_thread_num());
+        QueueRandom random(omp_get_thread_num() + 2);
+        AStarState current;
+        unsigned polls = 0;
+        while (!guard.tripped()) {
+            active.fetch_add(1);
+            if (!open.tryPop(current, random)) {
+                active.fetch_sub(1);
+                if (open.size() == 0 && active.load() == 0) break;
+                this_thread::yield();
+                continue;
+            }
+            if (current.cost + current.heuristic < incumbent.load() && costs.isCurrent(current.board, current.cost)) {
+                long long expanded = ++expandedNodes;
+                if (guard.overLimits(expanded, costs.size()) ||
+                    (++polls % BudgetGuard::CLOCK_STRIDE == 0 && guard.timeUp())) {
+                    active.fetch_sub(1);
+                    break;
+                }
 
                 int row = current.blankPos / 4;
                 int col = current.blankPos % 4;
-
-                for (int dir = 0; dir < 4; dir++) {
+                for (int dir = 0; dir < 4; ++dir) {
                     int newRow = row + dRow[dir];
                     int newCol = col + dCol[dir];
+                    if (newRow < 0 || newRow >= 4 || newCol < 0 || newCol >= 4) continue;
 
-                    if (newRow >= 0 && newRow < 4 && newCol >= 0 && newCol < 4) {
-                        int newPos = newRow * 4 + newCol;
-                        string newBoard = swapBoardTiles(current.board, current.blankPos, newPos);
-
-                        #pragma omp critical
-                        {
-                            if (visited.find(newBoard) == visited.end()) {
-                                visited.insert(newBoard);
-                                int newCost = current.cost + 1;
-                                int newHeuristic = h1_heuristic(newBoard);
-                                local_new_states.push_back(AStarState(newBoard, newPos, newCost, newHeuristic));
-                            }
-                        }
+                    int newPos = newRow * 4 + newCol;
+                    int newCost = current.cost + 1;
+                    string newBoard = swapBoardTiles(current.board, current.blankPos, newPos);
+                    if (newBoard == TARGET) {
+                        offer(newCost);
+                        continue;
+                    }
+                    int newHeur = h1_heuristic(newBoard);
+                    if (newCost + newHeur < incumbent.load() && costs.improve(newBoard, newCost)) {
+                        open.push(AStarState(newBoard, newPos, newCost, newHeur, weight), random);
                     }
                 }
             }
-
-            #pragma omp critical
-            {
-                for (const auto& state : local_new_states) {
-                    new_states.push_back(state);
-                }
-            }
+            active.fetch_sub(1);
         }
+    }
 
-        for (const auto& state : new_states) {
-            pq.push(state);
+    if (stats) *stats = {expandedNodes.load(), costs.size()};
+    if (guard.tripped()) {
+        if (verboseOutput) {
+            cout << "Presupuesto excedido (" << guard.reasonText() << ")" << endl;
+            cout << "Nodos expandidos: " << expandedNodes.load() << endl;
+            cout << "Estados visitados: " << costs.size() << endl;
+            if (open.size() > 0) cout << "Mejor f en la frontera: " << open.minKey() << endl;
         }
+        return BUDGET_EXCEEDED;
     }
-
-    return solution_cost;
+    return incumbent.load() == INT_MAX ? -1 : incumbent.load();
 }
 
+int main(int argc, char* argv[]) {
+    double weight = 1.0;
+    bool useMultiQueue = false;
+    OutputFormat format = FORMAT_TEXT;
+    string inputPath = "puzzles.txt";
+    string goalText;
+    PlacementOptions placement;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--multiqueue") {
+            useMultiQueue = true;
+        } else if (arg == "-w" && i + 1 < argc) {
+            weight = stod(argv[++i]);
+        } else if (arg == "--format" && i + 1 < argc && parseOutputFormat(argv[i + 1], format)) {
+            i++;
+        } else if (arg == "--input" && i + 1 < argc) {
+            inputPath = argv[++i];
+        } else if (arg == "--goal" && i + 1 < argc) {
+            goalText = argv[++i];
+        } else if (parsePlacementOption(i, argc, argv, placement)) {
+            continue;
+        } else if (parseCheckpointOption(i, argc, argv, checkpointOptions)) {
+            continue;
+        } else if (!parseBudgetOption(i, argc, argv, searchBudget)) {
+            cerr << "Uso: " << argv[0] << " [-w <peso>] [--multiqueue] [--bind none|compact|spread] [--sockets <n>] [--time-limit <s>] [--max-nodes <n>] [--max-mem <MB>] [--checkpoint <dir>] [--checkpoint-every <s>] [--format text|jsonl|csv] [--input <archivo>] [--goal <tablero>]" << endl;
+            return 1;
+        }
+    }
+    if (weight < 1.0) {
+        cerr << "El peso debe ser >= 1.0" << endl;
+        return 1;
+    }
+    GoalRelabeling relabeling;
+    if (!goalText.empty()) {
+        vector<uint16_t> goal;
+        string error;
+        if (!parseTiles(goalText, 4, goal, error)) {
+            cerr << "Error: objetivo no válido " << goalText << ": " << error << endl;
+            return 1;
+        }
+        relabeling = GoalRelabeling(goal, 4);
+        TARGET = formatTiles(relabeling.goal(), 4);
+    }
+    verboseOutput = format == FORMAT_TEXT;
+    if (!checkpointOptions.directory.empty()) installCheckpointSignals();
+    threadPlacement = ThreadPlacement(placement);
+    if (verboseOutput && threadPlacement.enabled()) cout << "Hilos: " << threadPlacement.describe() << endl;
 
-int main() {
-    ifstream infile("puzzles.txt");
-    if (!infile) {
-        cerr << "Error: no se pudo abrir puzzles.txt" << endl;
+    BoardSource infile(inputPath);
+    if (!infile.is_open()) {
+        cerr << "Error: no se pudo abrir " << inputPath << endl;
+        return 1;
+    }
+    if (infile.side() != 0 && infile.side() != 4) {
+        cerr << "Error: el conjunto de tableros no es de 4x4" << endl;
         return 1;
     }
 
     string start;
-    while (infile >> start) {
+    ResultWriter writer(stdout, format);
+    long long puzzleIndex = 0;
+    while (!checkpointStopRequested() && infile.next(start)) {
+        puzzleIndex++;
+        vector<uint16_t> tiles;
+        string error;
+        if (!parseTiles(start, 4, tiles, error)) {
+            cerr << "Tablero no válido " << start << ": " << error << endl;
+            if (!verboseOutput) writer.write({puzzleIndex, start, INVALID_BOARD, SearchStats(), 0});
+            continue;
+        }
+        string board = formatTiles(relabeling.apply(tiles), 4);
+        if (!verboseOutput) {
+            SearchStats stats;
+            double start_time = omp_get_wtime();
+            int result = useMultiQueue ? multiQueue_aStarSearch(board, weight, &stats) : parallel_aStarSearch(board, weight, &stats);
+            // A signal stopped the search after its snapshot; a rerun resumes it.
+            if (checkpointStopRequested()) break;
+            writer.write({puzzleIndex, start, result, stats, omp_get_wtime() - start_time});
+            continue;
+        }
+
         cout << "Procesando tablero: " << start << endl;
         double start_time = omp_get_wtime();
-        int result = parallel_aStarSearch(start);
+        int result = useMultiQueue ? multiQueue_aStarSearch(board, weight) : parallel_aStarSearch(board, weight);
         double end_time = omp_get_wtime();
-        if (result != -1)
+        if (checkpointStopRequested()) break;
+        if (result == BUDGET_EXCEEDED)
+            cout << "Resultado: presupuesto excedido" << endl;
+        else if (result != -1)
             cout << "Resultado: " << result << endl;
         else
             cout << "No se encontró solución." << endl;
@@ -169,6 +452,5 @@ int main() {
         cout << endl;
     }
 
-    infile.close();
     return 0;
 }
\ No newline at end of file
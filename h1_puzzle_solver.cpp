@@ -7,6 +7,11 @@
  * 
  * Goal state: "ABCDEFGHIJKLMNO#"
  * Where '#' represents the empty space.
+ *
+ * Larger boards use the unique tile IDs of puzzle_tiles.h (tile k belongs in
+ * cell k - 1), so a tile is only counted as placed in its own goal cell.
+ * A --goal other than the canonical one is relabeled onto it (see
+ * goal_relabel.h).
  * 
  * @author JAPeTo
  * @version 1.6
@@ -19,75 +24,164 @@
 #include <functional>
 #include <chrono>
 #include <fstream>  
+#include <unordered_map>
+#include <climits>
+#include <thread>
+#include <atomic>
+#include "search_budget.h"
+#include "result_writer.h"
+#include "puzzle_set.h"
+#include "puzzle_tiles.h"
+#include "macro_solver.h"
+#include "heuristic_kernels.h"
+#include "compact_closed_list.h"
+#include "search_checkpoint.h"
+#include "goal_relabel.h"
 
 using namespace std;
 using namespace std::chrono;
 
-string goal = "";
 int sizeBoard = 0;
+string goal8;
+u16string goal16;
+vector<int8_t> moveDelta;
+SearchBudget searchBudget;
+CheckpointOptions checkpointOptions;
+bool verboseOutput = true;
 
+/**
+ * @brief Search node ordered by f = g + w*h
+ *
+ * With weight 1.0 this is plain A*. A weight w > 1 gives weighted A*, whose
+ * solutions are at most w times longer than the optimum. Both bounds rely on
+ * closing a board when it is expanded, not when it is generated.
+ */
+template <class Board>
 struct AStarState {
-    string board;
+    Board board;
     int blankPos;
     int cost;  
     int heuristic; 
+    double f;
     
-    AStarState(string b, int pos, int c, int h) : board(b), blankPos(pos), cost(c), heuristic(h) {}
+    AStarState(const Board& b, int pos, int c, int h, double w = 1.0) : board(b), blankPos(pos), cost(c), heuristic(h), f(c + w * h) {}
     
     bool operator>(const AStarState& other) const {
-        return (cost + heuristic) > (other.cost + other.heuristic);
+        if (f != other.f) return f > other.f;
+        return cost < other.cost;
     }
 };
 
 const int dRow[] = {-1, 1, 0, 0}; 
 const int dCol[] = {0, 0, -1, 1};
 
-string swapBoardTiles(const string &currentBoard, int position1, int position2){
-      string newBoard = currentBoard;
-      char tmp = currentBoard[position1];
+const string& goalBoard(const string&) { return goal8; }
+const u16string& goalBoard(const u16string&) { return goal16; }
+
+template <class Board>
+Board swapBoardTiles(const Board &currentBoard, int position1, int position2){
+      Board newBoard = currentBoard;
+      auto tmp = currentBoard[position1];
       newBoard[position1] = currentBoard[position2];
       newBoard[position2] = tmp;
       return newBoard;
 }
 
-int h1_heuristic(const string& board) {
-    int misplaced = 0;
-    for (int i = 0; i < sizeBoard * sizeBoard; i++) {
-        if (board[i] != '#' && board[i] != goal[i]) {
-            misplaced++;
-        }
-    }
-    return misplaced;
+template <class Board>
+int h1_heuristic(const Board& board) {
+    return misplacedTiles(board, goalBoard(board));
 }
 
-int aStarSearch(string start){
+template <class Board>
+int aStarSearch(const Board& start, double weight = 1.0, SearchStats* stats = nullptr){
+      typedef AStarState<Board> AStarState;
       priority_queue<AStarState, vector<AStarState>, greater<AStarState>> pq;
-      unordered_set<string> visited;
+      ClosedList<Board> visited(start.size());
       int expandedNodes = 0;
+      BudgetGuard guard(searchBudget, ClosedList<Board>::stateBytes(start));
+      SearchCheckpoint checkpoint(checkpointOptions, "h1", "w=" + to_string(weight) + " g=" + to_string(blankPosition(goalBoard(start))), start);
+      const Board& goal = goalBoard(start);
       
-      int blankPos = -1;
-      for (int i = 0; i < sizeBoard * sizeBoard; i++) {
-            if (start[i] == '#') {
-                  blankPos = i;
-                  break;
+      const size_t cells = start.size();
+
+      // The heap array is saved in its layout; a node popped but not expanded is pushed back first.
+      auto saveSnapshot = [&](long long expanded) {
+            return checkpoint.save([&](SnapshotWriter& out) {
+                  const vector<AStarState>& open = adaptorContainer(pq);
+                  out.put<int64_t>(expanded);
+                  out.put<uint64_t>(open.size());
+                  auto putState = [&](const AStarState& s) {
+                        out.putBoard(s.board);
+                        out.put<int32_t>(s.cost);
+                        out.put<int32_t>(s.heuristic);
+                  };
+                  for (const AStarState& s : open) putState(s);
+                  visited.save(out);
+            });
+      };
+
+      bool resumed = checkpoint.resume([&](SnapshotReader& in) {
+            expandedNodes = (int)in.get<int64_t>();
+            uint64_t count = in.get<uint64_t>();
+            vector<AStarState>& open = adaptorContainer(pq);
+            Board board;
+            for (uint64_t i = 0; i < count; i++) {
+                  in.getBoard(board, cells);
+                  int cost = in.get<int32_t>();
+                  int heuristic = in.get<int32_t>();
+                  open.push_back(AStarState(board, blankPosition(board), cost, heuristic, weight));
             }
+            visited.load(in, cells);
+      });
+      if (resumed) {
+            if (verboseOutput) cout << "Reanudando desde " << checkpoint.path() << ": " << expandedNodes
+                                    << " nodos expandidos, " << visited.size() << " estados visitados" << endl;
+      } else {
+            expandedNodes = 0;
+            pq = priority_queue<AStarState, vector<AStarState>, greater<AStarState>>();
+            visited = ClosedList<Board>(cells);
+            pq.push(AStarState(start, blankPosition(start), 0, h1_heuristic(start), weight));
       }
-
-      int initialHeuristic = h1_heuristic(start);
-    
-      pq.push(AStarState(start, blankPos, 0, initialHeuristic));
-      visited.insert(start);
       
       while (!pq.empty()) {
+            if (checkpoint.due()) {
+                  saveSnapshot(expandedNodes);
+                  if (checkpoint.interrupted()) {
+                        if (verboseOutput) cout << "Búsqueda interrumpida; instantánea en " << checkpoint.path() << endl;
+                        return BUDGET_EXCEEDED;
+                  }
+            }
+
             AStarState current = pq.top();
             pq.pop();
+            // A board is closed when expanded; later copies in the heap are stale.
+            if (visited.contains(current.board)) continue;
             expandedNodes++;
+            size_t stored = visited.size() + pq.size();
+            if (stats) *stats = {expandedNodes, stored};
+
+            if (guard.check(expandedNodes, stored)) {
+                  pq.push(current);
+                  bool saved = saveSnapshot(expandedNodes - 1);
+                  if (verboseOutput) {
+                        cout << "Presupuesto excedido (" << guard.reasonText() << ")" << endl;
+                        cout << "Nodos expandidos: " << expandedNodes << endl;
+                        cout << "Estados visitados: " << stored << endl;
+                        cout << "Mejor f en la frontera: " << current.cost + current.heuristic << endl;
+                        if (saved) cout << "Instantánea en " << checkpoint.path() << endl;
+                  }
+                  return BUDGET_EXCEEDED;
+            }
             
             if (current.board == goal) {
-                  cout << "Nodos expandidos: " << expandedNodes << endl;
-                  cout << "Longitud de la solución: " << current.cost << endl;
+                  checkpoint.discard();
+                  if (verboseOutput) {
+                        cout << "Nodos expandidos: " << expandedNodes << endl;
+                        cout << "Longitud de la solución: " << current.cost << endl;
+                  }
                   return current.cost;
             }
+            visited.insert(current.board);
             int row = current.blankPos / sizeBoard;
             int col = current.blankPos % sizeBoard;
             
@@ -97,66 +191,418 @@ int aStarSearch(string start){
                   
                   if (newRow >= 0 && newRow < sizeBoard && newCol >= 0 && newCol < sizeBoard) {
                         int newPos = newRow * sizeBoard + newCol;
-                        string newBoard = swapBoardTiles(current.board, current.blankPos, newPos);
+                        Board newBoard = swapBoardTiles(current.board, current.blankPos, newPos);
                         
-                        if (visited.find(newBoard) == visited.end()) {
+                        if (!visited.contains(newBoard)) {
                               int newCost = current.cost + 1;
                               int newHeuristic = h1_heuristic(newBoard);
                               
-                              pq.push(AStarState(newBoard, newPos, newCost, newHeuristic));
-                              visited.insert(newBoard);
+                              pq.push(AStarState(newBoard, newPos, newCost, newHeuristic, weight));
                         }
                   }
             }
       }
-    cout << "Nodos expandidos: " << expandedNodes << endl;
+    checkpoint.discard();
+    if (verboseOutput) cout << "Nodos expandidos: " << expandedNodes << endl;
     return -1; 
 }
 
+/**
+ * @brief Change of the misplaced-tiles count for every (tile, blank cell, move)
+ *
+ * moveDelta[(tile * cells + blankPos) * 4 + dir] is h(child) - h(parent) when
+ * the blank at blankPos moves in direction dir and `tile` slides into it.
+ * Only the moved tile changes, so the value is -1, 0 or +1.
+ */
+void buildMoveDelta(const vector<uint16_t>& goalTiles) {
+      int cells = sizeBoard * sizeBoard;
+      moveDelta.assign((size_t)cells * cells * 4, 0);
+      for (int tile = 1; tile < cells; tile++) {
+            for (int blankPos = 0; blankPos < cells; blankPos++) {
+                  int row = blankPos / sizeBoard;
+                  int col = blankPos % sizeBoard;
+                  for (int i = 0; i < 4; i++) {
+                        int newRow = row + dRow[i];
+                        int newCol = col + dCol[i];
+                        if (newRow < 0 || newRow >= sizeBoard || newCol < 0 || newCol >= sizeBoard) continue;
+                        int newPos = newRow * sizeBoard + newCol;
+                        int before = goalTiles[newPos] != tile;
+                        int after = goalTiles[blankPos] != tile;
+                        moveDelta[((size_t)tile * cells + blankPos) * 4 + i] = (int8_t)(after - before);
+                  }
+            }
+      }
+}
+
+/**
+ * @brief Enhanced partial-expansion A* (EPEA*) with the misplaced-tiles heuristic
+ *
+ * Same scheme as in h2_puzzle_solver.cpp: a node is stored with a value F,
+ * initially its f, and expanding it generates only the children whose f
+ * equals F (read from moveDelta without building them). If some child has a
+ * larger f the node is reinserted with F set to the smallest of those.
+ */
+template <class Board>
+int epeaStarSearch(const Board& start, SearchStats* stats = nullptr){
+      typedef AStarState<Board> AStarState;
+      priority_queue<AStarState, vector<AStarState>, greater<AStarState>> pq;
+      unordered_map<Board, int> g;
+      int expandedNodes = 0;
+      int cells = sizeBoard * sizeBoard;
+      BudgetGuard guard(searchBudget, estimatedStateBytes(start.size() * sizeof(start[0])));
+      const Board& goal = goalBoard(start);
+
+      g[start] = 0;
+      pq.push(AStarState(start, blankPosition(start), 0, h1_heuristic(start)));
+
+      while (!pq.empty()) {
+            AStarState current = pq.top();
+            pq.pop();
+            if (g[current.board] != current.cost) continue;
+            expandedNodes++;
+            if (stats) *stats = {expandedNodes, g.size()};
+
+            if (guard.check(expandedNodes, g.size())) {
+                  if (verboseOutput) {
+                        cout << "Presupuesto excedido (" << guard.reasonText() << ")" << endl;
+                        cout << "Nodos expandidos: " << expandedNodes << endl;
+                        cout << "Estados visitados: " << g.size() << endl;
+                        cout << "Mejor f en la frontera: " << current.f << endl;
+                  }
+                  return BUDGET_EXCEEDED;
+            }
+
+            if (current.board == goal) {
+                  if (verboseOutput) {
+                        cout << "Nodos expandidos: " << expandedNodes << endl;
+                        cout << "Longitud de la solución: " << current.cost << endl;
+                  }
+                  return current.cost;
+            }
+
+            int storedF = (int)current.f;
+            int nextF = INT_MAX;
+            int row = current.blankPos / sizeBoard;
+            int col = current.blankPos % sizeBoard;
+            for (int i = 0; i < 4; i++) {
+                  int newRow = row + dRow[i];
+                  int newCol = col + dCol[i];
+                  if (newRow < 0 || newRow >= sizeBoard || newCol < 0 || newCol >= sizeBoard) continue;
+
+                  int newPos = newRow * sizeBoard + newCol;
+                  int tile = tileAt(current.board[newPos]);
+                  int delta = moveDelta[((size_t)tile * cells + current.blankPos) * 4 + i];
+                  int childF = current.cost + 1 + current.heuristic + delta;
+                  if (childF < storedF) continue;
+                  if (childF > storedF) {
+                        nextF = min(nextF, childF);
+                        continue;
+                  }
+
+                  int newCost = current.cost + 1;
+                  Board newBoard = swapBoardTiles(current.board, current.blankPos, newPos);
+                  auto it = g.find(newBoard);
+                  if (it != g.end() && it->second <= newCost) continue;
+                  g[newBoard] = newCost;
+                  pq.push(AStarState(newBoard, newPos, newCost, current.heuristic + delta));
+            }
+            if (nextF != INT_MAX) {
+                  current.f = nextF;
+                  pq.push(current);
+            }
+      }
+      if (verboseOutput) cout << "Nodos expandidos: " << expandedNodes << endl;
+      return -1;
+}
+
+/**
+ * @brief Anytime Repairing A* (ARA*) with the misplaced-tiles heuristic
+ *
+ * Starts with weighted A* at initialWeight and lowers the weight by
+ * weightStep after each published solution. States whose cost improves after
+ * being closed go to INCONS and are reinserted at the next iteration, so the
+ * work of earlier iterations is reused. Each solution is printed together with
+ * its suboptimality bound min(w, g(goal) / min_{OPEN u INCONS} (g + h)).
+ */
+template <class Board>
+int araStarSearch(const Board& start, double initialWeight, double timeBudget, double weightStep = 0.5, SearchStats* stats = nullptr){
+      typedef AStarState<Board> AStarState;
+      auto deadline = steady_clock::now() + duration_cast<steady_clock::duration>(duration<double>(timeBudget));
+      unordered_map<Board, int> g;
+      unordered_set<Board> closed;
+      unordered_map<Board, int> incons;
+      vector<AStarState> open;
+      auto cmp = greater<AStarState>();
+      int expandedNodes = 0;
+      int goalCost = INT_MAX;
+      double w = max(1.0, initialWeight);
+      BudgetGuard guard(searchBudget, estimatedStateBytes(start.size() * sizeof(start[0])));
+      const Board& goal = goalBoard(start);
+
+      int blankPos = blankPosition(start);
+      g[start] = 0;
+      open.push_back(AStarState(start, blankPos, 0, h1_heuristic(start), w));
+
+      auto stale = [&](const AStarState& s) {
+            return closed.count(s.board) || g[s.board] != s.cost;
+      };
+      auto timeLeft = [&]() { return steady_clock::now() < deadline; };
+
+      auto improvePath = [&]() {
+            while (!open.empty() && timeLeft() && !guard.check(expandedNodes, g.size())) {
+                  if (goalCost <= open.front().f) break;
+                  pop_heap(open.begin(), open.end(), cmp);
+                  AStarState current = open.back();
+                  open.pop_back();
+                  if (stale(current)) continue;
+                  closed.insert(current.board);
+                  expandedNodes++;
+
+                  int row = current.blankPos / sizeBoard;
+                  int col = current.blankPos % sizeBoard;
+                  for (int i = 0; i < 4; i++) {
+                        int newRow = row + dRow[i];
+                        int newCol = col + dCol[i];
+                        if (newRow < 0 || newRow >= sizeBoard || newCol < 0 || newCol >= sizeBoard) continue;
+
+                        int newPos = newRow * sizeBoard + newCol;
+                        Board newBoard = swapBoardTiles(current.board, current.blankPos, newPos);
+                        int newCost = current.cost + 1;
+                        auto it = g.find(newBoard);
+                        if (it != g.end() && it->second <= newCost) continue;
+                        g[newBoard] = newCost;
+                        if (newBoard == goal) goalCost = newCost;
+
+                        if (closed.count(newBoard)) {
+                              incons[newBoard] = newPos;
+                        } else {
+                              open.push_back(AStarState(newBoard, newPos, newCost, h1_heuristic(newBoard), w));
+                              push_heap(open.begin(), open.end(), cmp);
+                        }
+                  }
+            }
+      };
+
+      auto suboptimalityBound = [&]() {
+            if (goalCost == INT_MAX) return (double)INT_MAX;
+            int lowest = goalCost;
+            for (const auto& s : open) {
+                  if (!stale(s)) lowest = min(lowest, s.cost + s.heuristic);
+            }
+            for (const auto& entry : incons) {
+                  lowest = min(lowest, g[entry.first] + h1_heuristic(entry.first));
+            }
+            return min(w, (double)goalCost / max(1, lowest));
+      };
+
+      while (true) {
+            improvePath();
+            if (goalCost != INT_MAX && verboseOutput) {
+                  cout << "Solución con w=" << w << ": " << goalCost
+                       << " (cota de suboptimalidad: " << suboptimalityBound() << ")" << endl;
+            }
+            if (w <= 1.0 || !timeLeft() || guard.tripped()) break;
+
+            w = max(1.0, w - weightStep);
+            vector<AStarState> next;
+            for (const auto& s : open) {
+                  if (!stale(s)) next.push_back(AStarState(s.board, s.blankPos, s.cost, s.heuristic, w));
+            }
+            for (const auto& entry : incons) {
+                  const Board& board = entry.first;
+                  next.push_back(AStarState(board, entry.second, g[board], h1_heuristic(board), w));
+            }
+            incons.clear();
+            closed.clear();
+            open.swap(next);
+            make_heap(open.begin(), open.end(), cmp);
+      }
+
+      if (stats) *stats = {expandedNodes, g.size()};
+      if (verboseOutput) {
+            if (guard.tripped()) cout << "Presupuesto excedido (" << guard.reasonText() << ")" << endl;
+            cout << "Nodos expandidos: " << expandedNodes << endl;
+      }
+      if (goalCost == INT_MAX) {
+            // Only an emptied open list proves there is no solution; otherwise the
+            // ARA* deadline or the budget stopped the search before its first one.
+            bool exhausted = incons.empty();
+            for (const auto& s : open) exhausted = exhausted && stale(s);
+            if (!exhausted) {
+                  if (verboseOutput) {
+                        if (!guard.tripped()) cout << "Tiempo de ARA* agotado sin solución" << endl;
+                        cout << "Estados generados: " << g.size() << endl;
+                  }
+                  return BUDGET_EXCEEDED;
+            }
+            return -1;
+      }
+      if (verboseOutput) cout << "Longitud de la solución: " << goalCost << endl;
+      return goalCost;
+}
+
+/**
+ * @brief Constructive, non-optimal solution for boards too large for optimal search
+ *
+ * Used by default from 16x16 up, or on request with --macro (see
+ * macro_solver.h). The residual IDA* nodes are reported as expanded nodes.
+ */
+int macroSearch(const vector<uint16_t>& tiles, const vector<uint16_t>& goalTiles, SearchStats* stats = nullptr){
+      MacroSolver solver(tiles, goalTiles, sizeBoard);
+      vector<int> moves;
+      int result = solver.solve(moves);
+      if (stats) *stats = {solver.residualNodes(), 0};
+      if (verboseOutput) {
+            if (result < 0) cout << "Tablero sin solución" << endl;
+            else cout << "Solución constructiva (no óptima): " << solver.macroMoves() << " movimientos de macros + "
+                      << result - (int)solver.macroMoves() << " del residuo" << endl;
+      }
+      return result;
+}
+
 int main(int argc, char* argv[]){
       if (argc < 2) {
-            cerr << "Uso: " << argv[0] << " <tamaño_tablero>" << endl;
+            cerr << "Uso: " << argv[0] << " <tamaño_tablero> [-w <peso>] [--ara <segundos>] [--time-limit <s>] [--max-nodes <n>] [--max-mem <MB>] [--checkpoint <dir>] [--checkpoint-every <s>] [--format text|jsonl|csv] [--jobs <n>] [--input <archivo>] [--goal <tablero>] [--macro|--optimal] [--epea]" << endl;
             return 1;
       }
 
       sizeBoard = stoi(argv[1]);
-      if(sizeBoard == 4){
-            goal = "ABCDEFGHIJKLMNO#";
-            cout << "Goal size: " << goal.size() << endl;
+
+      double weight = 1.0;
+      double araBudget = -1.0;
+      OutputFormat format = FORMAT_TEXT;
+      int jobs = 1;
+      string inputPath = "puzzles.txt";
+      string goalText;
+      bool useMacro = sizeBoard >= MACRO_AUTO_SIDE;
+      bool useEpea = false;
+      for (int i = 2; i < argc; i++) {
+            string arg = argv[i];
+            if (arg == "--macro") useMacro = true;
+            else if (arg == "--optimal") useMacro = false;
+            else if (arg == "--epea") useEpea = true;
+            else if (arg == "-w" && i + 1 < argc) weight = stod(argv[++i]);
+            else if (arg == "--ara" && i + 1 < argc) araBudget = stod(argv[++i]);
+            else if (arg == "--jobs" && i + 1 < argc) jobs = max(1, stoi(argv[++i]));
+            else if (arg == "--input" && i + 1 < argc) inputPath = argv[++i];
+            else if (arg == "--goal" && i + 1 < argc) goalText = argv[++i];
+            else if (arg == "--format" && i + 1 < argc && parseOutputFormat(argv[i + 1], format)) i++;
+            else if (parseBudgetOption(i, argc, argv, searchBudget)) continue;
+            else if (parseCheckpointOption(i, argc, argv, checkpointOptions)) continue;
+            else {
+                  cerr << "Opción desconocida: " << arg << endl;
+                  return 1;
+            }
+      }
+      if (weight < 1.0) {
+            cerr << "El peso debe ser >= 1.0" << endl;
+            return 1;
       }
-      else if(sizeBoard == 8){
-            goal = "ABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJK#";
-            cout << "Goal size: " << goal.size() << endl;
+      if (useEpea && (weight != 1.0 || araBudget >= 0)) {
+            cerr << "--epea no se combina con -w ni con --ara" << endl;
+            return 1;
       }
-      else if(sizeBoard == 16){
-            goal = "ABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTU#";
-            cout << "Goal size: " << goal.size() << endl;
+      verboseOutput = format == FORMAT_TEXT && jobs == 1;
+      if (!checkpointOptions.directory.empty()) installCheckpointSignals();
+      if (sizeBoard < 2 || sizeBoard > 255) {
+            cerr << "Tamaño no soportado." << endl;
+            return 1;
       }
-      else if(sizeBoard == 32){
-            goal = "ABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHI#";            
-            cout << "Goal size: " << goal.size() << endl;
+      // A custom goal is relabeled onto the canonical layout (see goal_relabel.h); starts follow it.
+      GoalRelabeling relabeling;
+      if (!goalText.empty()) {
+            vector<uint16_t> goal;
+            string error;
+            if (!parseTiles(goalText, sizeBoard, goal, error)) {
+                  cerr << "Error: objetivo no válido " << goalText << ": " << error << endl;
+                  return 1;
+            }
+            relabeling = GoalRelabeling(goal, sizeBoard);
       }
+      vector<uint16_t> goalTiles = goalText.empty() ? canonicalGoalTiles(sizeBoard) : relabeling.goal();
+      if (usesWideTiles(sizeBoard)) goal16 = toBoard<u16string>(goalTiles);
+      else goal8 = toBoard<string>(goalTiles);
+      if (useEpea) {
+            if (sizeBoard > 32) {
+                  cerr << "EPEA* admite tableros de hasta 32x32" << endl;
+                  return 1;
+            }
+            buildMoveDelta(goalTiles);
+      }
+      if (verboseOutput) cout << "Goal size: " << goalTiles.size() << endl;
+      if (verboseOutput && !goalText.empty()) cout << "Objetivo " << goalText << " reetiquetado como " << formatTiles(goalTiles, sizeBoard) << endl;
 
-      ifstream infile("puzzles.txt");
+      BoardSource infile(inputPath);
       if (!infile.is_open()) {
-            cerr << "Error: no se pudo abrir puzzles.txt" << endl;
+            cerr << "Error: no se pudo abrir " << inputPath << endl;
+            return 1;
+      }
+      if (infile.side() != 0 && infile.side() != sizeBoard) {
+            cerr << "Error: el conjunto de tableros no es de " << sizeBoard << "x" << sizeBoard << endl;
             return 1;
       }
 
-      string start;
-      while (infile >> start) {
-            cout << "Procesando tablero: " << start << endl;
+      auto solve = [&](const SourceBoard& input, SearchStats* stats) {
+            vector<uint16_t> tiles;
+            string error;
+            if (!input.parse(sizeBoard, tiles, error)) {
+                  cerr << "Tablero no válido " << input.text() << ": " << error << endl;
+                  return INVALID_BOARD;
+            }
+            tiles = relabeling.apply(tiles);
+            if (useMacro) return macroSearch(tiles, goalTiles, stats);
+            auto run = [&](const auto& board) {
+                  if (useEpea) return epeaStarSearch(board, stats);
+                  return araBudget >= 0 ? araStarSearch(board, weight > 1.0 ? weight : 3.0, araBudget, 0.5, stats)
+                                        : aStarSearch(board, weight, stats);
+            };
+            return usesWideTiles(sizeBoard) ? run(toBoard<u16string>(tiles)) : run(toBoard<string>(tiles));
+      };
+
+      SourceBoard start;
+      if (!verboseOutput) {
+            // Records are tagged with the puzzle index and written as each worker finishes.
+            vector<SourceBoard> boards;
+            while (infile.next(start)) boards.push_back(start);
+
+            ResultWriter writer(stdout, format);
+            atomic<size_t> nextBoard(0);
+            auto worker = [&]() {
+                  size_t i;
+                  while (!checkpointStopRequested() && (i = nextBoard++) < boards.size()) {
+                        SearchStats stats;
+                        auto start_time = steady_clock::now();
+                        int result = solve(boards[i], &stats);
+                        // A signal stopped the search after its snapshot; a rerun resumes it.
+                        if (checkpointStopRequested()) break;
+                        double elapsed = duration<double>(steady_clock::now() - start_time).count();
+                        writer.write({(long long)i + 1, boards[i].text(), result, stats, elapsed});
+                  }
+            };
+            vector<thread> pool;
+            for (int t = 0; t < jobs; t++) pool.emplace_back(worker);
+            for (auto& t : pool) t.join();
+            return 0;
+      }
+
+      while (!checkpointStopRequested() && infile.next(start)) {
+            cout << "Procesando tablero: " << start.text() << endl;
 
             auto start_time = high_resolution_clock::now();
-            int result = aStarSearch(start);
+            int result = solve(start, nullptr);
             auto end_time = high_resolution_clock::now();
+            if (checkpointStopRequested()) break;
 
             double elapsed = duration<double>(end_time - start_time).count();
-            cout << "Resultado: " << result << endl;
+            if (result == BUDGET_EXCEEDED)
+                  cout << "Resultado: presupuesto excedido" << endl;
+            else if (result == INVALID_BOARD)
+                  cout << "Resultado: tablero no válido" << endl;
+            else
+                  cout << "Resultado: " << result << endl;
             cout << "Tiempo de ejecución: " << elapsed << " segundos" << endl;
             cout <<  endl;
       }
 
-      infile.close();
       return 0;
 }
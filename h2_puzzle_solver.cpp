@@ -4,6 +4,11 @@
  * 
  * Reads multiple puzzles from "puzzles.txt" and solves each one.
  * Measures execution time using <chrono>.
+ *
+ * Boards use the unique tile IDs of puzzle_tiles.h, so every tile has a
+ * single goal cell and the Manhattan distance is exact for any board size.
+ * A --goal other than the canonical one is relabeled onto it (see
+ * goal_relabel.h).
  */
 
 #include <iostream>
@@ -14,78 +19,222 @@
 #include <cmath>
 #include <fstream>
 #include <chrono>
+#include <unordered_map>
+#include <climits>
+#include <thread>
+#include <atomic>
+#include "search_budget.h"
+#include "result_writer.h"
+#include "puzzle_set.h"
+#include "puzzle_tiles.h"
+#include "macro_solver.h"
+#include "heuristic_kernels.h"
+#include "compact_closed_list.h"
+#include "search_checkpoint.h"
+#include "goal_relabel.h"
 using namespace std;
 
-string goal = "";
 int sizeBoard = 0;
+GoalTable goalTable;
+vector<int8_t> moveDelta;
+string goal8;
+u16string goal16;
+SearchBudget searchBudget;
+CheckpointOptions checkpointOptions;
+bool verboseOutput = true;
 
+/**
+ * @brief Search node ordered by f = g + w*h
+ *
+ * With weight 1.0 this is plain A*. A weight w > 1 gives weighted A*, whose
+ * solutions are at most w times longer than the optimum. Both bounds rely on
+ * closing a board when it is expanded, not when it is generated.
+ */
+template <class Board>
 struct AStarState {
-    string board;
+    Board board;
     int blankPos;
     int cost;  
     int heuristic; 
+    double f;
     
-    AStarState(string b, int pos, int c, int h) : board(b), blankPos(pos), cost(c), heuristic(h) {}
+    AStarState(const Board& b, int pos, int c, int h, double w = 1.0) : board(b), blankPos(pos), cost(c), heuristic(h), f(c + w * h) {}
     
     bool operator>(const AStarState& other) const {
-        return (cost + heuristic) > (other.cost + other.heuristic);
+        if (f != other.f) return f > other.f;
+        return cost < other.cost;
     }
 };
 
 const int dRow[] = {-1, 1, 0, 0};
 const int dCol[] = {0, 0, -1, 1};
 
-string swapBoardTiles(const string &currentBoard, int position1, int position2){
-    string newBoard = currentBoard;
+const string& goalBoard(const string&) { return goal8; }
+const u16string& goalBoard(const u16string&) { return goal16; }
+
+template <class Board>
+Board swapBoardTiles(const Board &currentBoard, int position1, int position2){
+    Board newBoard = currentBoard;
     swap(newBoard[position1], newBoard[position2]);
     return newBoard;
 }
 
-int h2_heuristic(const string& board) {
-    int totalDistance = 0;
-    for (int i = 0; i < sizeBoard * sizeBoard; i++) {
-        char tile = board[i];
-        if (tile == '#') continue;
-        
-        int targetPos = -1;
-        for (int j = 0; j < sizeBoard * sizeBoard; j++) {
-            if (goal[j] == tile) {
-                targetPos = j;
-                break;
+template <class Board>
+int h2_heuristic(const Board& board) {
+    return manhattanDistance(board, goalTable);
+}
+
+/**
+ * @brief Exact distances to the goal for every board within perimeterDepth moves
+ *
+ * Built once per process by a backward BFS from the goal. Every board that is
+ * not in the table is at least perimeterDepth + 1 moves away, so A* can raise
+ * its heuristic to that bound outside the perimeter and use the exact distance
+ * inside it.
+ */
+int perimeterDepth = 0;
+unordered_map<string, uint8_t> perimeter8;
+unordered_map<u16string, uint8_t> perimeter16;
+
+unordered_map<string, uint8_t>& perimeterTable(const string&) { return perimeter8; }
+unordered_map<u16string, uint8_t>& perimeterTable(const u16string&) { return perimeter16; }
+
+template <class Board>
+void buildPerimeter(const Board& goal, int depth) {
+    unordered_map<Board, uint8_t>& table = perimeterTable(goal);
+    table.clear();
+    table.emplace(goal, 0);
+    vector<pair<Board, int>> layer = {{goal, blankPosition(goal)}}, next;
+    for (int d = 1; d <= depth && !layer.empty(); d++) {
+        next.clear();
+        for (const auto& [board, blankPos] : layer) {
+            int row = blankPos / sizeBoard;
+            int col = blankPos % sizeBoard;
+            for (int i = 0; i < 4; i++) {
+                int newRow = row + dRow[i];
+                int newCol = col + dCol[i];
+                if (newRow < 0 || newRow >= sizeBoard || newCol < 0 || newCol >= sizeBoard) continue;
+                int newPos = newRow * sizeBoard + newCol;
+                Board newBoard = swapBoardTiles(board, blankPos, newPos);
+                if (table.emplace(newBoard, (uint8_t)d).second) next.emplace_back(move(newBoard), newPos);
             }
         }
-        if (targetPos != -1) {
-            int currentRow = i / sizeBoard;
-            int currentCol = i % sizeBoard;
-            int targetRow = targetPos / sizeBoard;
-            int targetCol = targetPos % sizeBoard;
-            totalDistance += abs(currentRow - targetRow) + abs(currentCol - targetCol);
-        }
+        layer.swap(next);
     }
-    return totalDistance;
+    perimeterDepth = depth;
+}
+
+/**
+ * @brief h2 corrected with the perimeter: exact inside it, at least perimeterDepth + 1 outside
+ *
+ * Still consistent: a board just outside the perimeter is at most one move
+ * from one at depth perimeterDepth, and its Manhattan distance is at most
+ * perimeterDepth + 1. A* therefore expands every board with its optimal g.
+ */
+template <class Board>
+int perimeterHeuristic(const Board& board) {
+    int h = h2_heuristic(board);
+    // Manhattan never overestimates, so a board with h > perimeterDepth is outside.
+    if (perimeterDepth == 0 || h > perimeterDepth) return h;
+    const auto& table = perimeterTable(board);
+    auto it = table.find(board);
+    return it != table.end() ? it->second : max(h, perimeterDepth + 1);
 }
 
-int aStarSearch(string start){
+template <class Board>
+int aStarSearch(const Board& start, double weight = 1.0, SearchStats* stats = nullptr){
+    typedef AStarState<Board> AStarState;
     priority_queue<AStarState, vector<AStarState>, greater<AStarState>> pq;
-    unordered_set<string> visited;
+    ClosedList<Board> visited(start.size());
     int expandedNodes = 0;
+    BudgetGuard guard(searchBudget, ClosedList<Board>::stateBytes(start));
+    SearchCheckpoint checkpoint(checkpointOptions, "h2", "w=" + to_string(weight) + " p=" + to_string(perimeterDepth) +
+                                " g=" + to_string(blankPosition(goalBoard(start))), start);
+    const Board& goal = goalBoard(start);
     
-    int blankPos = start.find('#');
-    int initialHeuristic = h2_heuristic(start);
-    
-    pq.push(AStarState(start, blankPos, 0, initialHeuristic));
-    visited.insert(start);
+    const size_t cells = start.size();
+
+    // The heap array is saved in its layout; a node popped but not expanded is pushed back first.
+    auto saveSnapshot = [&](long long expanded) {
+        return checkpoint.save([&](SnapshotWriter& out) {
+            const vector<AStarState>& open = adaptorContainer(pq);
+            out.put<int64_t>(expanded);
+            out.put<uint64_t>(open.size());
+            auto putState = [&](const AStarState& s) {
+                out.putBoard(s.board);
+                out.put<int32_t>(s.cost);
+                out.put<int32_t>(s.heuristic);
+            };
+            for (const AStarState& s : open) putState(s);
+            visited.save(out);
+        });
+    };
+
+    bool resumed = checkpoint.resume([&](SnapshotReader& in) {
+        expandedNodes = (int)in.get<int64_t>();
+        uint64_t count = in.get<uint64_t>();
+        vector<AStarState>& open = adaptorContainer(pq);
+        Board board;
+        for (uint64_t i = 0; i < count; i++) {
+            in.getBoard(board, cells);
+            int cost = in.get<int32_t>();
+            int heuristic = in.get<int32_t>();
+            open.push_back(AStarState(board, blankPosition(board), cost, heuristic, weight));
+        }
+        visited.load(in, cells);
+    });
+    if (resumed) {
+        if (verboseOutput) cout << "Reanudando desde " << checkpoint.path() << ": " << expandedNodes
+                                << " nodos expandidos, " << visited.size() << " estados visitados" << endl;
+    } else {
+        expandedNodes = 0;
+        pq = priority_queue<AStarState, vector<AStarState>, greater<AStarState>>();
+        visited = ClosedList<Board>(cells);
+        pq.push(AStarState(start, blankPosition(start), 0, perimeterHeuristic(start), weight));
+    }
     
     while (!pq.empty()) {
+        if (checkpoint.due()) {
+            saveSnapshot(expandedNodes);
+            if (checkpoint.interrupted()) {
+                if (verboseOutput) cout << "Búsqueda interrumpida; instantánea en " << checkpoint.path() << endl;
+                return BUDGET_EXCEEDED;
+            }
+        }
+
         AStarState current = pq.top();
         pq.pop();
+        // A board is closed when expanded; later copies in the heap are stale.
+        if (visited.contains(current.board)) continue;
         expandedNodes++;
+        size_t stored = visited.size() + pq.size();
+        if (stats) *stats = {expandedNodes, stored};
+
+        if (guard.check(expandedNodes, stored)) {
+            pq.push(current);
+            bool saved = saveSnapshot(expandedNodes - 1);
+            if (verboseOutput) {
+                cout << "Presupuesto excedido (" << guard.reasonText() << ")" << endl;
+                cout << "Nodos expandidos: " << expandedNodes << endl;
+                cout << "Estados visitados: " << stored << endl;
+                cout << "Mejor f en la frontera: " << current.cost + current.heuristic << endl;
+                if (saved) cout << "Instantánea en " << checkpoint.path() << endl;
+            }
+            return BUDGET_EXCEEDED;
+        }
         
-        if (current.board == goal) {
-            cout << "Nodos expandidos: " << expandedNodes << endl;
-            cout << "Longitud de la solución: " << current.cost << endl;
-            return current.cost;
+        // Inside the perimeter the heuristic is the exact remaining distance, and
+        // g is optimal because boards are closed on expansion, so g + h is too.
+        if (current.board == goal || (perimeterDepth > 0 && current.heuristic <= perimeterDepth)) {
+            checkpoint.discard();
+            int length = current.cost + current.heuristic;
+            if (verboseOutput) {
+                cout << "Nodos expandidos: " << expandedNodes << endl;
+                cout << "Longitud de la solución: " << length << endl;
+            }
+            return length;
         }
+        visited.insert(current.board);
         int row = current.blankPos / sizeBoard;
         int col = current.blankPos % sizeBoard;
         
@@ -95,59 +244,445 @@ int aStarSearch(string start){
             
             if (newRow >= 0 && newRow < sizeBoard && newCol >= 0 && newCol < sizeBoard) {
                 int newPos = newRow * sizeBoard + newCol;
-                string newBoard = swapBoardTiles(current.board, current.blankPos, newPos);
+                Board newBoard = swapBoardTiles(current.board, current.blankPos, newPos);
                 
-                if (visited.find(newBoard) == visited.end()) {
+                if (!visited.contains(newBoard)) {
                     int newCost = current.cost + 1;
-                    int newHeuristic = h2_heuristic(newBoard);
-                    pq.push(AStarState(newBoard, newPos, newCost, newHeuristic));
-                    visited.insert(newBoard);
+                    int newHeuristic = perimeterHeuristic(newBoard);
+                    pq.push(AStarState(newBoard, newPos, newCost, newHeuristic, weight));
                 }
             }
         }
     }
-    cout << "Nodos expandidos: " << expandedNodes << endl;
+    checkpoint.discard();
+    if (verboseOutput) cout << "Nodos expandidos: " << expandedNodes << endl;
     return -1; 
 }
 
+/**
+ * @brief Change of the Manhattan distance for every (tile, blank cell, move)
+ *
+ * moveDelta[(tile * cells + blankPos) * 4 + dir] is h(child) - h(parent) when
+ * the blank at blankPos moves in direction dir and `tile` slides into it.
+ * It is always -1 or +1, so a child's f is the parent's f or f + 2.
+ */
+void buildMoveDelta() {
+    int cells = sizeBoard * sizeBoard;
+    moveDelta.assign((size_t)cells * cells * 4, 0);
+    for (int tile = 1; tile < cells; tile++) {
+        for (int blankPos = 0; blankPos < cells; blankPos++) {
+            int row = blankPos / sizeBoard;
+            int col = blankPos % sizeBoard;
+            for (int i = 0; i < 4; i++) {
+                int newRow = row + dRow[i];
+                int newCol = col + dCol[i];
+                if (newRow < 0 || newRow >= sizeBoard || newCol < 0 || newCol >= sizeBoard) continue;
+                int before = abs(newRow - goalTable.row[tile]) + abs(newCol - goalTable.col[tile]);
+                int after = abs(row - goalTable.row[tile]) + abs(col - goalTable.col[tile]);
+                moveDelta[((size_t)tile * cells + blankPos) * 4 + i] = (int8_t)(after - before);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Enhanced partial-expansion A* (EPEA*)
+ *
+ * A node is stored with a value F, initially its f. Expanding it generates
+ * only the children whose f equals F, using moveDelta to know each child's f
+ * without building it; if other children have a larger f the node goes back
+ * to the open list with F set to the smallest of them. Children that will
+ * never be needed are never created, which keeps the open list close to the
+ * size of the frontier that is actually expanded.
+ *
+ * The closed list keeps the best g of each board, so a board reached again
+ * more cheaply is reopened and stale entries are skipped when popped.
+ */
+template <class Board>
+int epeaStarSearch(const Board& start, SearchStats* stats = nullptr){
+    typedef AStarState<Board> AStarState;
+    priority_queue<AStarState, vector<AStarState>, greater<AStarState>> pq;
+    unordered_map<Board, int> g;
+    int expandedNodes = 0;
+    int cells = sizeBoard * sizeBoard;
+    BudgetGuard guard(searchBudget, estimatedStateBytes(start.size() * sizeof(start[0])));
+    const Board& goal = goalBoard(start);
+
+    g[start] = 0;
+    pq.push(AStarState(start, blankPosition(start), 0, h2_heuristic(start)));
+
+    while (!pq.empty()) {
+        AStarState current = pq.top();
+        pq.pop();
+        if (g[current.board] != current.cost) continue;
+        expandedNodes++;
+        if (stats) *stats = {expandedNodes, g.size()};
+
+        if (guard.check(expandedNodes, g.size())) {
+            if (verboseOutput) {
+                cout << "Presupuesto excedido (" << guard.reasonText() << ")" << endl;
+                cout << "Nodos expandidos: " << expandedNodes << endl;
+                cout << "Estados visitados: " << g.size() << endl;
+                cout << "Mejor f en la frontera: " << current.f << endl;
+            }
+            return BUDGET_EXCEEDED;
+        }
+
+        if (current.board == goal) {
+            if (verboseOutput) {
+                cout << "Nodos expandidos: " << expandedNodes << endl;
+                cout << "Longitud de la solución: " << current.cost << endl;
+            }
+            return current.cost;
+        }
+
+        int storedF = (int)current.f;
+        int nextF = INT_MAX;
+        int row = current.blankPos / sizeBoard;
+        int col = current.blankPos % sizeBoard;
+        for (int i = 0; i < 4; i++) {
+            int newRow = row + dRow[i];
+            int newCol = col + dCol[i];
+            if (newRow < 0 || newRow >= sizeBoard || newCol < 0 || newCol >= sizeBoard) continue;
+
+            int newPos = newRow * sizeBoard + newCol;
+            int tile = tileAt(current.board[newPos]);
+            int delta = moveDelta[((size_t)tile * cells + current.blankPos) * 4 + i];
+            int childF = current.cost + 1 + current.heuristic + delta;
+            if (childF < storedF) continue;
+            if (childF > storedF) {
+                nextF = min(nextF, childF);
+                continue;
+            }
+
+            int newCost = current.cost + 1;
+            Board newBoard = swapBoardTiles(current.board, current.blankPos, newPos);
+            auto it = g.find(newBoard);
+            if (it != g.end() && it->second <= newCost) continue;
+            g[newBoard] = newCost;
+            pq.push(AStarState(newBoard, newPos, newCost, current.heuristic + delta));
+        }
+        if (nextF != INT_MAX) {
+            current.f = nextF;
+            pq.push(current);
+        }
+    }
+    if (verboseOutput) cout << "Nodos expandidos: " << expandedNodes << endl;
+    return -1;
+}
+
+/**
+ * @brief Anytime Repairing A* (ARA*)
+ *
+ * Runs weighted A* with a decreasing weight, reusing the search effort of
+ * the previous iteration. Nodes whose g improves after being closed are kept
+ * in INCONS and reinserted when the weight drops. Every time a solution is
+ * published the current suboptimality bound is printed:
+ *   min(w, g(goal) / min_{s in OPEN u INCONS} (g(s) + h(s)))
+ *
+ * Stops when the weight reaches 1.0 (solution proven optimal) or when the
+ * time budget is exhausted, returning the best cost found so far.
+ */
+template <class Board>
+int araStarSearch(const Board& start, double initialWeight, double timeBudget, double weightStep = 0.5, SearchStats* stats = nullptr){
+    typedef AStarState<Board> AStarState;
+    auto deadline = chrono::steady_clock::now() + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(timeBudget));
+    unordered_map<Board, int> g;
+    unordered_set<Board> closed;
+    unordered_map<Board, int> incons;
+    vector<AStarState> open;
+    auto cmp = greater<AStarState>();
+    int expandedNodes = 0;
+    int goalCost = INT_MAX;
+    double w = max(1.0, initialWeight);
+    BudgetGuard guard(searchBudget, estimatedStateBytes(start.size() * sizeof(start[0])));
+    const Board& goal = goalBoard(start);
+
+    g[start] = 0;
+    open.push_back(AStarState(start, blankPosition(start), 0, h2_heuristic(start), w));
+
+    auto stale = [&](const AStarState& s) {
+        return closed.count(s.board) || g[s.board] != s.cost;
+    };
+    auto timeLeft = [&]() { return chrono::steady_clock::now() < deadline; };
+
+    auto improvePath = [&]() {
+        while (!open.empty() && timeLeft() && !guard.check(expandedNodes, g.size())) {
+            if (goalCost <= open.front().f) break;
+            pop_heap(open.begin(), open.end(), cmp);
+            AStarState current = open.back();
+            open.pop_back();
+            if (stale(current)) continue;
+            closed.insert(current.board);
+            expandedNodes++;
+
+            int row = current.blankPos / sizeBoard;
+            int col = current.blankPos % sizeBoard;
+            for (int i = 0; i < 4; i++) {
+                int newRow = row + dRow[i];
+                int newCol = col + dCol[i];
+                if (newRow < 0 || newRow >= sizeBoard || newCol < 0 || newCol >= sizeBoard) continue;
+
+                int newPos = newRow * sizeBoard + newCol;
+                Board newBoard = swapBoardTiles(current.board, current.blankPos, newPos);
+                int newCost = current.cost + 1;
+                auto it = g.find(newBoard);
+                if (it != g.end() && it->second <= newCost) continue;
+                g[newBoard] = newCost;
+                if (newBoard == goal) goalCost = newCost;
+
+                if (closed.count(newBoard)) {
+                    incons[newBoard] = newPos;
+                } else {
+                    open.push_back(AStarState(newBoard, newPos, newCost, h2_heuristic(newBoard), w));
+                    push_heap(open.begin(), open.end(), cmp);
+                }
+            }
+        }
+    };
+
+    auto suboptimalityBound = [&]() {
+        if (goalCost == INT_MAX) return (double)INT_MAX;
+        int lowest = goalCost;
+        for (const auto& s : open) {
+            if (!stale(s)) lowest = min(lowest, s.cost + s.heuristic);
+        }
+        for (const auto& entry : incons) {
+            lowest = min(lowest, g[entry.first] + h2_heuristic(entry.first));
+        }
+        return min(w, (double)goalCost / max(1, lowest));
+    };
+
+    while (true) {
+        improvePath();
+        if (goalCost != INT_MAX && verboseOutput) {
+            cout << "Solución con w=" << w << ": " << goalCost
+                 << " (cota de suboptimalidad: " << suboptimalityBound() << ")" << endl;
+        }
+        if (w <= 1.0 || !timeLeft() || guard.tripped()) break;
+
+        w = max(1.0, w - weightStep);
+        vector<AStarState> next;
+        for (const auto& s : open) {
+            if (!stale(s)) next.push_back(AStarState(s.board, s.blankPos, s.cost, s.heuristic, w));
+        }
+        for (const auto& entry : incons) {
+            const Board& board = entry.first;
+            next.push_back(AStarState(board, entry.second, g[board], h2_heuristic(board), w));
+        }
+        incons.clear();
+        closed.clear();
+        open.swap(next);
+        make_heap(open.begin(), open.end(), cmp);
+    }
+
+    if (stats) *stats = {expandedNodes, g.size()};
+    if (verboseOutput) {
+        if (guard.tripped()) cout << "Presupuesto excedido (" << guard.reasonText() << ")" << endl;
+        cout << "Nodos expandidos: " << expandedNodes << endl;
+    }
+    if (goalCost == INT_MAX) {
+        // Only an emptied open list proves there is no solution; otherwise the
+        // ARA* deadline or the budget stopped the search before its first one.
+        bool exhausted = incons.empty();
+        for (const auto& s : open) exhausted = exhausted && stale(s);
+        if (!exhausted) {
+            if (verboseOutput) {
+                if (!guard.tripped()) cout << "Tiempo de ARA* agotado sin solución" << endl;
+                cout << "Estados generados: " << g.size() << endl;
+            }
+            return BUDGET_EXCEEDED;
+        }
+        return -1;
+    }
+    if (verboseOutput) cout << "Longitud de la solución: " << goalCost << endl;
+    return goalCost;
+}
+
+/**
+ * @brief Constructive, non-optimal solution for boards too large for optimal search
+ *
+ * Used by default from 16x16 up, or on request with --macro (see
+ * macro_solver.h). The residual IDA* nodes are reported as expanded nodes.
+ */
+int macroSearch(const vector<uint16_t>& tiles, const vector<uint16_t>& goalTiles, SearchStats* stats = nullptr){
+    MacroSolver solver(tiles, goalTiles, sizeBoard);
+    vector<int> moves;
+    int result = solver.solve(moves);
+    if (stats) *stats = {solver.residualNodes(), 0};
+    if (verboseOutput) {
+        if (result < 0) cout << "Tablero sin solución" << endl;
+        else cout << "Solución constructiva (no óptima): " << solver.macroMoves() << " movimientos de macros + "
+                  << result - (int)solver.macroMoves() << " del residuo" << endl;
+    }
+    return result;
+}
+
 int main(int argc, char* argv[]){
     if (argc < 2) {
-        cerr << "Uso: ./solver <tamaño_tablero>\n";
+        cerr << "Uso: ./solver <tamaño_tablero> [-w <peso>] [--ara <segundos>] [--time-limit <s>] [--max-nodes <n>] [--max-mem <MB>] [--checkpoint <dir>] [--checkpoint-every <s>] [--format text|jsonl|csv] [--jobs <n>] [--input <archivo>] [--goal <tablero>] [--macro|--optimal] [--epea] [--perimeter <k>]\n";
         return 1;
     }
 
     sizeBoard = stoi(argv[1]);
 
-    if (sizeBoard == 4) goal = "ABCDEFGHIJKLMNO#";
-    else if (sizeBoard == 8) goal = "ABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJK#";
-    else if (sizeBoard == 16) goal = "ABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTU#";
-    else if (sizeBoard == 32) goal = "ABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHI#";
-    else {
+    double weight = 1.0;
+    double araBudget = -1.0;
+    OutputFormat format = FORMAT_TEXT;
+    int jobs = 1;
+    string inputPath = "puzzles.txt";
+    string goalText;
+    bool useMacro = sizeBoard >= MACRO_AUTO_SIDE;
+    bool useEpea = false;
+    int perimeter = 0;
+    for (int i = 2; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--macro") useMacro = true;
+        else if (arg == "--optimal") useMacro = false;
+        else if (arg == "--epea") useEpea = true;
+        else if (arg == "-w" && i + 1 < argc) weight = stod(argv[++i]);
+        else if (arg == "--ara" && i + 1 < argc) araBudget = stod(argv[++i]);
+        else if (arg == "--perimeter" && i + 1 < argc) perimeter = stoi(argv[++i]);
+        else if (arg == "--jobs" && i + 1 < argc) jobs = max(1, stoi(argv[++i]));
+        else if (arg == "--input" && i + 1 < argc) inputPath = argv[++i];
+        else if (arg == "--goal" && i + 1 < argc) goalText = argv[++i];
+        else if (arg == "--format" && i + 1 < argc && parseOutputFormat(argv[i + 1], format)) i++;
+        else if (parseBudgetOption(i, argc, argv, searchBudget)) continue;
+        else if (parseCheckpointOption(i, argc, argv, checkpointOptions)) continue;
+        else {
+            cerr << "Opción desconocida: " << arg << "\n";
+            return 1;
+        }
+    }
+    if (weight < 1.0) {
+        cerr << "El peso debe ser >= 1.0\n";
+        return 1;
+    }
+    if (useEpea && (weight != 1.0 || araBudget >= 0)) {
+        cerr << "--epea no se combina con -w ni con --ara\n";
+        return 1;
+    }
+    if (perimeter < 0 || perimeter > 250) {
+        cerr << "La profundidad del perímetro debe estar entre 0 y 250\n";
+        return 1;
+    }
+    if (perimeter > 0 && (useEpea || araBudget >= 0)) {
+        cerr << "--perimeter solo se usa con A* (no con --epea ni con --ara)\n";
+        return 1;
+    }
+    verboseOutput = format == FORMAT_TEXT && jobs == 1;
+    if (!checkpointOptions.directory.empty()) installCheckpointSignals();
+
+    if (sizeBoard < 2 || sizeBoard > 255) {
         cerr << "Tamaño no soportado.\n";
         return 1;
     }
+    // A custom goal is relabeled onto the canonical layout (see goal_relabel.h); starts follow it.
+    GoalRelabeling relabeling;
+    if (!goalText.empty()) {
+        vector<uint16_t> goal;
+        string error;
+        if (!parseTiles(goalText, sizeBoard, goal, error)) {
+            cerr << "Error: objetivo no válido " << goalText << ": " << error << "\n";
+            return 1;
+        }
+        relabeling = GoalRelabeling(goal, sizeBoard);
+    }
+    vector<uint16_t> goalTiles = goalText.empty() ? canonicalGoalTiles(sizeBoard) : relabeling.goal();
+    goalTable = GoalTable(goalTiles, sizeBoard);
+    if (usesWideTiles(sizeBoard)) goal16 = toBoard<u16string>(goalTiles);
+    else goal8 = toBoard<string>(goalTiles);
+    if (verboseOutput && !goalText.empty()) cout << "Objetivo " << goalText << " reetiquetado como " << formatTiles(goalTiles, sizeBoard) << "\n";
+    if (useEpea) {
+        if (sizeBoard > 32) {
+            cerr << "EPEA* admite tableros de hasta 32x32\n";
+            return 1;
+        }
+        buildMoveDelta();
+    }
+    if (perimeter > 0 && !useMacro) {
+        auto start_time = chrono::steady_clock::now();
+        if (usesWideTiles(sizeBoard)) buildPerimeter(goal16, perimeter);
+        else buildPerimeter(goal8, perimeter);
+        double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start_time).count();
+        if (verboseOutput) {
+            cout << "Perímetro de profundidad " << perimeter << ": "
+                 << (usesWideTiles(sizeBoard) ? perimeter16.size() : perimeter8.size())
+                 << " tableros en " << elapsed << " segundos" << endl;
+        }
+    }
 
-    ifstream infile("puzzles.txt");
-    if (!infile) {
-        cerr << "Error: no se pudo abrir puzzles.txt\n";
+    BoardSource infile(inputPath);
+    if (!infile.is_open()) {
+        cerr << "Error: no se pudo abrir " << inputPath << "\n";
         return 1;
     }
+    if (infile.side() != 0 && infile.side() != sizeBoard) {
+        cerr << "Error: el conjunto de tableros no es de " << sizeBoard << "x" << sizeBoard << "\n";
+        return 1;
+    }
+
+    auto solve = [&](const SourceBoard& input, SearchStats* stats) {
+        vector<uint16_t> tiles;
+        string error;
+        if (!input.parse(sizeBoard, tiles, error)) {
+            cerr << "Tablero no válido " << input.text() << ": " << error << "\n";
+            return INVALID_BOARD;
+        }
+        tiles = relabeling.apply(tiles);
+        if (useMacro) return macroSearch(tiles, goalTiles, stats);
+        auto run = [&](const auto& board) {
+            if (useEpea) return epeaStarSearch(board, stats);
+            return araBudget >= 0 ? araStarSearch(board, weight > 1.0 ? weight : 3.0, araBudget, 0.5, stats)
+                                  : aStarSearch(board, weight, stats);
+        };
+        return usesWideTiles(sizeBoard) ? run(toBoard<u16string>(tiles)) : run(toBoard<string>(tiles));
+    };
+
+    SourceBoard start;
+    if (!verboseOutput) {
+        // Records are tagged with the puzzle index and written as each worker finishes.
+        vector<SourceBoard> boards;
+        while (infile.next(start)) boards.push_back(start);
+
+        ResultWriter writer(stdout, format);
+        atomic<size_t> nextBoard(0);
+        auto worker = [&]() {
+            size_t i;
+            while (!checkpointStopRequested() && (i = nextBoard++) < boards.size()) {
+                SearchStats stats;
+                auto start_time = chrono::steady_clock::now();
+                int result = solve(boards[i], &stats);
+                // A signal stopped the search after its snapshot; a rerun resumes it.
+                if (checkpointStopRequested()) break;
+                double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start_time).count();
+                writer.write({(long long)i + 1, boards[i].text(), result, stats, elapsed});
+            }
+        };
+        vector<thread> pool;
+        for (int t = 0; t < jobs; t++) pool.emplace_back(worker);
+        for (auto& t : pool) t.join();
+        return 0;
+    }
 
-    string start;
-    int caseNum = 1;
-    while (infile >> start) {
-        cout << "Procesando tablero: " << start << endl;
+    while (!checkpointStopRequested() && infile.next(start)) {
+        cout << "Procesando tablero: " << start.text() << endl;
 
         auto start_time = chrono::high_resolution_clock::now();
-        int result = aStarSearch(start);
+        int result = solve(start, nullptr);
         auto end_time = chrono::high_resolution_clock::now();
+        if (checkpointStopRequested()) break;
 
         double elapsed = chrono::duration<double>(end_time - start_time).count();
-        cout << "Resultado: " << (result != -1 ? to_string(result) : "No resuelto") << endl;
+        if (result == BUDGET_EXCEEDED)
+            cout << "Resultado: presupuesto excedido" << endl;
+        else if (result == INVALID_BOARD)
+            cout << "Resultado: tablero no válido" << endl;
+        else
+            cout << "Resultado: " << (result != -1 ? to_string(result) : "No resuelto") << endl;
         cout << "Tiempo de ejecución: " << elapsed << " segundos\n";
         cout << endl;
     }
 
-    infile.close();
     return 0;
 }
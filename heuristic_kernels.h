@@ -0,0 +1,203 @@
+/**
+ * @file heuristic_kernels.h
+ * @brief Vectorised misplaced-tiles (h1) and Manhattan (h2) kernels
+ *
+ * Both heuristics scan the whole board, which dominates the cost of a full
+ * evaluation on 16x16 and 32x32 boards. The kernels here process 16 or 32
+ * cells per step:
+ *
+ *   misplaced   byte/word compare against the goal and against the blank,
+ *               movemask, popcount
+ *   manhattan   tile IDs widened to 32 bits, goal row/column gathered from
+ *               the GoalTable, abs-diff against the cell row/column, blank
+ *               lanes masked out
+ *
+ * The implementation is picked once at runtime from CPUID (AVX2, then
+ * SSE4.2, then scalar), so the binaries need no -mavx2 and still run on older
+ * CPUs. PUZZLE_SIMD=scalar|sse|avx2 caps the level, which is handy for
+ * comparing the paths. Every path returns exactly the scalar result.
+ */
+#ifndef HEURISTIC_KERNELS_H
+#define HEURISTIC_KERNELS_H
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include "puzzle_tiles.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HEURISTIC_KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+enum SimdLevel { SIMD_SCALAR = 0, SIMD_SSE42, SIMD_AVX2 };
+
+inline SimdLevel detectSimdLevel() {
+    SimdLevel level = SIMD_SCALAR;
+#ifdef HEURISTIC_KERNELS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("popcnt")) {
+        if (__builtin_cpu_supports("avx2")) level = SIMD_AVX2;
+        else if (__builtin_cpu_supports("sse4.2")) level = SIMD_SSE42;
+    }
+#endif
+    const char* cap = getenv("PUZZLE_SIMD");
+    if (cap && strcmp(cap, "scalar") == 0) level = SIMD_SCALAR;
+    else if (cap && strcmp(cap, "sse") == 0 && level > SIMD_SSE42) level = SIMD_SSE42;
+    return level;
+}
+
+inline SimdLevel simdLevel() {
+    static const SimdLevel level = detectSimdLevel();
+    return level;
+}
+
+inline const char* simdLevelName(SimdLevel level) {
+    switch (level) {
+        case SIMD_AVX2: return "avx2";
+        case SIMD_SSE42: return "sse4.2";
+        default: return "scalar";
+    }
+}
+
+namespace heuristic_kernels {
+
+template <class Cell>
+inline int misplacedScalar(const Cell* board, const Cell* goal, int cells) {
+    int misplaced = 0;
+    for (int i = 0; i < cells; i++) misplaced += board[i] != BLANK_TILE && board[i] != goal[i];
+    return misplaced;
+}
+
+template <class Cell>
+inline int manhattanScalar(const Cell* board, int first, int cells, const GoalTable& t) {
+    int totalDistance = 0;
+    for (int i = first; i < cells; i++) {
+        int tile = board[i];
+        if (tile == BLANK_TILE) continue;
+        totalDistance += abs(t.cellRow[i] - t.row[tile]) + abs(t.cellCol[i] - t.col[tile]);
+    }
+    return totalDistance;
+}
+
+#ifdef HEURISTIC_KERNELS_X86
+
+/*
+ * A lane counts as "in place" when it equals the goal or holds the blank;
+ * misplaced = lanes scanned - lanes in place. Word compares set two mask bits
+ * per lane, hence the shift by (sizeof(Cell) - 1).
+ */
+template <class Cell>
+__attribute__((target("sse4.2,popcnt")))
+int misplacedSse(const Cell* board, const Cell* goal, int cells) {
+    const int lanes = 16 / sizeof(Cell);
+    const __m128i zero = _mm_setzero_si128();
+    int inPlace = 0, i = 0;
+    for (; i + lanes <= cells; i += lanes) {
+        __m128i b = _mm_loadu_si128((const __m128i*)(board + i));
+        __m128i g = _mm_loadu_si128((const __m128i*)(goal + i));
+        __m128i same = sizeof(Cell) == 1 ? _mm_or_si128(_mm_cmpeq_epi8(b, g), _mm_cmpeq_epi8(b, zero))
+                                         : _mm_or_si128(_mm_cmpeq_epi16(b, g), _mm_cmpeq_epi16(b, zero));
+        inPlace += _mm_popcnt_u32(_mm_movemask_epi8(same)) >> (sizeof(Cell) - 1);
+    }
+    return i - inPlace + misplacedScalar(board + i, goal + i, cells - i);
+}
+
+template <class Cell>
+__attribute__((target("avx2,popcnt")))
+int misplacedAvx2(const Cell* board, const Cell* goal, int cells) {
+    const int lanes = 32 / sizeof(Cell);
+    const __m256i zero = _mm256_setzero_si256();
+    int inPlace = 0, i = 0;
+    for (; i + lanes <= cells; i += lanes) {
+        __m256i b = _mm256_loadu_si256((const __m256i*)(board + i));
+        __m256i g = _mm256_loadu_si256((const __m256i*)(goal + i));
+        __m256i same = sizeof(Cell) == 1 ? _mm256_or_si256(_mm256_cmpeq_epi8(b, g), _mm256_cmpeq_epi8(b, zero))
+                                         : _mm256_or_si256(_mm256_cmpeq_epi16(b, g), _mm256_cmpeq_epi16(b, zero));
+        inPlace += _mm_popcnt_u32((unsigned)_mm256_movemask_epi8(same)) >> (sizeof(Cell) - 1);
+    }
+    return i - inPlace + misplacedSse(board + i, goal + i, cells - i);
+}
+
+__attribute__((target("avx2")))
+inline __m256i widenTiles(const uint8_t* cells) {
+    return _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)cells));
+}
+
+__attribute__((target("avx2")))
+inline __m256i widenTiles(const uint16_t* cells) {
+    return _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)cells));
+}
+
+template <class Cell>
+__attribute__((target("avx2")))
+int manhattanAvx2(const Cell* board, int cells, const GoalTable& t) {
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i sum = zero;
+    int i = 0;
+    for (; i + 8 <= cells; i += 8) {
+        __m256i tiles = widenTiles(board + i);
+        __m256i goalRow = _mm256_i32gather_epi32(t.row.data(), tiles, 4);
+        __m256i goalCol = _mm256_i32gather_epi32(t.col.data(), tiles, 4);
+        __m256i cellRow = _mm256_loadu_si256((const __m256i*)(t.cellRow.data() + i));
+        __m256i cellCol = _mm256_loadu_si256((const __m256i*)(t.cellCol.data() + i));
+        __m256i distance = _mm256_add_epi32(_mm256_abs_epi32(_mm256_sub_epi32(cellRow, goalRow)),
+                                            _mm256_abs_epi32(_mm256_sub_epi32(cellCol, goalCol)));
+        sum = _mm256_add_epi32(sum, _mm256_andnot_si256(_mm256_cmpeq_epi32(tiles, zero), distance));
+    }
+    __m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(1, 0, 3, 2)));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(half) + manhattanScalar(board, i, cells, t);
+}
+
+#endif
+
+template <class Cell>
+inline int misplaced(const Cell* board, const Cell* goal, int cells) {
+#ifdef HEURISTIC_KERNELS_X86
+    SimdLevel level = simdLevel();
+    if (level == SIMD_AVX2) return misplacedAvx2(board, goal, cells);
+    if (level == SIMD_SSE42) return misplacedSse(board, goal, cells);
+#endif
+    return misplacedScalar(board, goal, cells);
+}
+
+/*
+ * There is no gather before AVX2, so the SSE level uses the scalar loop
+ * (which the compiler already unrolls well over the int tables).
+ */
+template <class Cell>
+inline int manhattan(const Cell* board, int cells, const GoalTable& t) {
+#ifdef HEURISTIC_KERNELS_X86
+    if (simdLevel() == SIMD_AVX2) return manhattanAvx2(board, cells, t);
+#endif
+    return manhattanScalar(board, 0, cells, t);
+}
+
+}
+
+/**
+ * @brief Tiles (blank excluded) that are not in their goal cell
+ */
+inline int misplacedTiles(const std::string& board, const std::string& goal) {
+    return heuristic_kernels::misplaced((const uint8_t*)board.data(), (const uint8_t*)goal.data(), (int)board.size());
+}
+
+inline int misplacedTiles(const std::u16string& board, const std::u16string& goal) {
+    return heuristic_kernels::misplaced((const uint16_t*)board.data(), (const uint16_t*)goal.data(), (int)board.size());
+}
+
+/**
+ * @brief Sum of the Manhattan distances of every tile (blank excluded) to its goal cell
+ */
+inline int manhattanDistance(const std::string& board, const GoalTable& goal) {
+    return heuristic_kernels::manhattan((const uint8_t*)board.data(), (int)board.size(), goal);
+}
+
+inline int manhattanDistance(const std::u16string& board, const GoalTable& goal) {
+    return heuristic_kernels::manhattan((const uint16_t*)board.data(), (int)board.size(), goal);
+}
+
+#endif
@@ -0,0 +1,382 @@
+/**
+ * @file macro_solver.h
+ * @brief Constructive (non-optimal) solver for boards too large for optimal search
+ *
+ * Solves the board one line at a time, like a person would: the top row of the
+ * unsolved region, then its left column, shrinking the region by one each
+ * round until only a small residual square (3x3 by default) is left in the
+ * bottom-right corner. The residual is relabeled as a small puzzle and solved
+ * optimally with IDA* and the Manhattan distance.
+ *
+ * Placing a tile is the usual routing macro: find a path for the tile through
+ * the unlocked cells, then for every step bring the blank in front of the tile
+ * (without passing through it or through locked cells) and slide the tile
+ * into it. The last two tiles of a line cannot be placed one after the other,
+ * so the first is parked in the line's last cell, the second is brought into
+ * the 3x2 window around them, and a tiny search over the window positions of
+ * those two tiles and the blank finishes the line.
+ *
+ * The lines and the residual need the goal's blank inside the residual
+ * square. Any other goal (goal_relabel.h slides the blank out of the corner
+ * for goals whose blank is not in one) is solved with its blank slid right
+ * and then down into the corner, and the blank is walked back at the end.
+ *
+ * Every tile takes O(side) steps of O(1) amortised moves, so a solution has
+ * O(side^3) moves and is found in a few milliseconds even for 32x32 boards.
+ *
+ * Moves are blank moves: 0 UP, 1 DOWN, 2 LEFT, 3 RIGHT, the same order as the
+ * dRow / dCol tables of the solvers.
+ */
+#ifndef MACRO_SOLVER_H
+#define MACRO_SOLVER_H
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+#include "puzzle_tiles.h"
+
+const int MACRO_RESIDUAL_SIDE = 3;
+const int MACRO_AUTO_SIDE = 16;
+
+inline const char* moveName(int move) {
+    static const char* const names[] = {"UP", "DOWN", "LEFT", "RIGHT"};
+    return names[move];
+}
+
+/**
+ * @brief True when the start can reach the goal (permutation parity matches blank distance parity)
+ */
+inline bool isSolvable(const std::vector<uint16_t>& start, const std::vector<uint16_t>& goal, int side) {
+    int cells = side * side;
+    std::vector<int> goalPos(cells);
+    for (int i = 0; i < cells; i++) goalPos[goal[i]] = i;
+    std::vector<char> seen(cells, 0);
+    int cycles = 0;
+    for (int i = 0; i < cells; i++) {
+        if (seen[i]) continue;
+        cycles++;
+        for (int j = i; !seen[j]; j = goalPos[start[j]]) seen[j] = 1;
+    }
+    int blank = blankPosition(start), blankGoal = goalPos[BLANK_TILE];
+    int blankDistance = abs(blank / side - blankGoal / side) + abs(blank % side - blankGoal % side);
+    return (cells - cycles) % 2 == blankDistance % 2;
+}
+
+class MacroSolver {
+public:
+    MacroSolver(const std::vector<uint16_t>& start, const std::vector<uint16_t>& goal, int side,
+                int residual = MACRO_RESIDUAL_SIDE)
+        : n_(side), residual_(std::max(2, std::min(residual, side))), board_(start), goal_(goal),
+          pos_(side * side), goalPos_(side * side), locked_(side * side, 0),
+          stamp_(side * side, 0), parent_(side * side, 0) {
+        int blank = blankPosition(goal_);
+        int corner = n_ - residual_;
+        if (blank / n_ < corner || blank % n_ < corner) {
+            // Right along the row, then down the last column; finish_ walks the blank back.
+            for (; blank % n_ < n_ - 1; blank++) {
+                std::swap(goal_[blank], goal_[blank + 1]);
+                finish_.push_back(2);
+            }
+            for (; blank / n_ < n_ - 1; blank += n_) {
+                std::swap(goal_[blank], goal_[blank + n_]);
+                finish_.push_back(0);
+            }
+            std::reverse(finish_.begin(), finish_.end());
+        }
+        for (int i = 0; i < n_ * n_; i++) {
+            pos_[board_[i]] = i;
+            goalPos_[goal_[i]] = i;
+        }
+        blank_ = pos_[BLANK_TILE];
+    }
+
+    /**
+     * @brief Solves the board; returns the number of moves or -1 when it is unsolvable
+     */
+    int solve(std::vector<int>& moves) {
+        moves_.clear();
+        if (!isSolvable(board_, goal_, n_)) return -1;
+        int t = 0;
+        for (; n_ - t > residual_; t++) {
+            transposed_ = false;
+            if (!solveLine(t, t)) return -1;
+            transposed_ = true;
+            if (!solveLine(t, t + 1)) return -1;
+        }
+        transposed_ = false;
+        macroMoves_ = moves_.size();
+        if (!solveResidual(t) || board_ != goal_) return -1;
+        for (int move : finish_) step(move);
+        moves = moves_;
+        return (int)moves_.size();
+    }
+
+    /**
+     * @brief Moves spent by the row/column macros, before the residual
+     */
+    size_t macroMoves() const { return macroMoves_; }
+
+    long long residualNodes() const { return residualNodes_; }
+
+private:
+    int cellAt(int row, int col) const { return transposed_ ? col * n_ + row : row * n_ + col; }
+
+    static int direction(int from, int to, int side) {
+        if (to == from - side) return 0;
+        if (to == from + side) return 1;
+        if (to == from - 1) return 2;
+        return 3;
+    }
+
+    int neighbour(int cell, int move) const {
+        int row = cell / n_, col = cell % n_;
+        switch (move) {
+            case 0: return row > 0 ? cell - n_ : -1;
+            case 1: return row < n_ - 1 ? cell + n_ : -1;
+            case 2: return col > 0 ? cell - 1 : -1;
+            default: return col < n_ - 1 ? cell + 1 : -1;
+        }
+    }
+
+    void step(int move) {
+        int next = neighbour(blank_, move);
+        uint16_t tile = board_[next];
+        board_[blank_] = tile;
+        pos_[tile] = blank_;
+        board_[next] = BLANK_TILE;
+        pos_[BLANK_TILE] = next;
+        blank_ = next;
+        moves_.push_back(move);
+    }
+
+    /**
+     * @brief Breadth-first path over unlocked cells from `from` to the first target reached
+     *
+     * Cells equal to avoidA / avoidB are treated as walls. Returns the cells of
+     * the path, `from` excluded, or an empty path when `from` is a target.
+     */
+    bool findPath(int from, const std::vector<int>& targets, int avoidA, int avoidB, std::vector<int>& path) {
+        path.clear();
+        if (round_ >= UINT_MAX - 2) {
+            std::fill(stamp_.begin(), stamp_.end(), 0);
+            round_ = 0;
+        }
+        unsigned targetMark = ++round_, seenMark = ++round_;
+        for (int target : targets) {
+            if (target == from) return true;
+            stamp_[target] = targetMark;
+        }
+        queue_.clear();
+        queue_.push_back(from);
+        bool targetFound = false;
+        int reached = -1;
+        stamp_[from] = seenMark;
+        for (size_t head = 0; head < queue_.size() && !targetFound; head++) {
+            int cell = queue_[head];
+            for (int move = 0; move < 4; move++) {
+                int next = neighbour(cell, move);
+                if (next < 0 || locked_[next] || next == avoidA || next == avoidB || stamp_[next] == seenMark) continue;
+                bool isTarget = stamp_[next] == targetMark;
+                stamp_[next] = seenMark;
+                parent_[next] = cell;
+                if (isTarget) {
+                    reached = next;
+                    targetFound = true;
+                    break;
+                }
+                queue_.push_back(next);
+            }
+        }
+        if (!targetFound) return false;
+        for (int cell = reached; cell != from; cell = parent_[cell]) path.push_back(cell);
+        std::reverse(path.begin(), path.end());
+        return true;
+    }
+
+    bool moveBlank(const std::vector<int>& targets, int avoidA, int avoidB = -1) {
+        std::vector<int> path;
+        if (!findPath(blank_, targets, avoidA, avoidB, path)) return false;
+        for (int cell : path) step(direction(blank_, cell, n_));
+        return true;
+    }
+
+    /**
+     * @brief Routes a tile to `target`; stops early once it enters a cell marked in `stopCells`
+     */
+    bool moveTile(uint16_t tile, int target, const std::vector<char>* stopCells = nullptr) {
+        std::vector<int> path;
+        if (!findPath(pos_[tile], {target}, -1, -1, path)) return false;
+        for (int next : path) {
+            if (stopCells && (*stopCells)[pos_[tile]]) return true;
+            if (!moveBlank({next}, pos_[tile])) return false;
+            step(direction(blank_, pos_[tile], n_));
+        }
+        return true;
+    }
+
+    /**
+     * @brief Places the tiles of line `row` (columns col0..n-1) in the current orientation
+     */
+    bool solveLine(int row, int col0) {
+        for (int col = col0; col < n_ - 2; col++) {
+            int cell = cellAt(row, col);
+            if (!moveTile(goal_[cell], cell)) return false;
+            locked_[cell] = 1;
+        }
+
+        int first = cellAt(row, n_ - 2), last = cellAt(row, n_ - 1);
+        uint16_t a = goal_[first], b = goal_[last];
+        if (pos_[a] != first || pos_[b] != last) {
+            if (!moveTile(a, last)) return false;
+            locked_[last] = 1;
+            std::vector<int> window;
+            std::vector<char> inWindow(n_ * n_, 0);
+            for (int r = row; r < row + 3; r++) {
+                for (int c = n_ - 2; c < n_; c++) {
+                    window.push_back(cellAt(r, c));
+                    inWindow[cellAt(r, c)] = 1;
+                }
+            }
+            if (!moveTile(b, cellAt(row + 2, n_ - 1), &inWindow)) return false;
+            locked_[last] = 0;
+            if (!inWindow[blank_] && !moveBlank(window, pos_[a], pos_[b])) return false;
+            if (!solveWindow(window, a, b, first, last)) return false;
+        }
+        locked_[first] = locked_[last] = 1;
+        return true;
+    }
+
+    /**
+     * @brief Exhaustive search over (tile a, tile b, blank) positions inside a 3x2 window
+     */
+    bool solveWindow(const std::vector<int>& window, uint16_t a, uint16_t b, int aTarget, int bTarget) {
+        const int size = (int)window.size();
+        auto indexOf = [&](int cell) { return (int)(std::find(window.begin(), window.end(), cell) - window.begin()); };
+        auto encode = [&](int ia, int ib, int iz) { return (ia * size + ib) * size + iz; };
+        std::vector<int> from(size * size * size, -1), viaMove(size * size * size, -1);
+        std::vector<int> open = {encode(indexOf(pos_[a]), indexOf(pos_[b]), indexOf(blank_))};
+        from[open[0]] = open[0];
+        int goalState = -1;
+        for (size_t head = 0; head < open.size(); head++) {
+            int state = open[head];
+            int ia = state / (size * size), ib = state / size % size, iz = state % size;
+            if (window[ia] == aTarget && window[ib] == bTarget) {
+                goalState = state;
+                break;
+            }
+            for (int move = 0; move < 4; move++) {
+                int next = neighbour(window[iz], move);
+                if (next < 0) continue;
+                int inext = indexOf(next);
+                if (inext == size) continue;
+                int na = ia == inext ? iz : ia, nb = ib == inext ? iz : ib;
+                int nextState = encode(na, nb, inext);
+                if (from[nextState] != -1) continue;
+                from[nextState] = state;
+                viaMove[nextState] = move;
+                open.push_back(nextState);
+            }
+        }
+        if (goalState < 0) return false;
+        std::vector<int> path;
+        for (int state = goalState; from[state] != state; state = from[state]) path.push_back(viaMove[state]);
+        for (auto it = path.rbegin(); it != path.rend(); ++it) step(*it);
+        return true;
+    }
+
+    /**
+     * @brief Relabels the bottom-right residual square and solves it optimally with IDA*
+     */
+    bool solveResidual(int t) {
+        int k = n_ - t;
+        std::vector<int> toGlobal(k * k);
+        std::vector<int> goalRow(k * k + 1, 0), goalCol(k * k + 1, 0);
+        std::vector<uint8_t> local(k * k);
+        int localBlank = -1;
+        for (int i = 0; i < k * k; i++) {
+            int cell = (t + i / k) * n_ + t + i % k;
+            toGlobal[i] = cell;
+            int gr = goalPos_[board_[cell]] / n_ - t, gc = goalPos_[board_[cell]] % n_ - t;
+            if (gr < 0 || gc < 0) return false;
+            local[i] = board_[cell] == BLANK_TILE ? 0 : (uint8_t)(gr * k + gc + 1);
+            if (board_[cell] == BLANK_TILE) localBlank = i;
+        }
+        for (int i = 0; i < k * k; i++) {
+            goalRow[i + 1] = i / k;
+            goalCol[i + 1] = i % k;
+        }
+        residualSide_ = k;
+        residualRow_ = &goalRow;
+        residualCol_ = &goalCol;
+        int bound = residualHeuristic(local);
+        std::vector<int> path;
+        while (true) {
+            int next = residualSearch(local, localBlank, 0, bound, -1, path);
+            if (next == -1) break;
+            if (next == INT_MAX) return false;
+            bound = next;
+        }
+        for (int move : path) step(move);
+        return true;
+    }
+
+    int residualHeuristic(const std::vector<uint8_t>& local) const {
+        int h = 0;
+        for (int i = 0; i < (int)local.size(); i++) {
+            if (local[i] == 0) continue;
+            h += abs(i / residualSide_ - (*residualRow_)[local[i]]) + abs(i % residualSide_ - (*residualCol_)[local[i]]);
+        }
+        return h;
+    }
+
+    /**
+     * @brief One IDA* iteration; -1 when solved, otherwise the next bound
+     */
+    int residualSearch(std::vector<uint8_t>& local, int blank, int g, int bound, int lastMove, std::vector<int>& path) {
+        residualNodes_++;
+        int h = residualHeuristic(local);
+        if (g + h > bound) return g + h;
+        if (h == 0) return -1;
+        static const int opposite[] = {1, 0, 3, 2};
+        int k = residualSide_, best = INT_MAX;
+        for (int move = 0; move < 4; move++) {
+            if (lastMove >= 0 && move == opposite[lastMove]) continue;
+            int row = blank / k, col = blank % k;
+            if ((move == 0 && row == 0) || (move == 1 && row == k - 1) || (move == 2 && col == 0) || (move == 3 && col == k - 1)) continue;
+            int next = move == 0 ? blank - k : move == 1 ? blank + k : move == 2 ? blank - 1 : blank + 1;
+            std::swap(local[blank], local[next]);
+            path.push_back(move);
+            int result = residualSearch(local, next, g + 1, bound, move, path);
+            if (result == -1) return -1;
+            path.pop_back();
+            std::swap(local[blank], local[next]);
+            best = std::min(best, result);
+        }
+        return best;
+    }
+
+    int n_;
+    int residual_;
+    std::vector<uint16_t> board_;
+    std::vector<uint16_t> goal_;
+    std::vector<int> pos_;
+    std::vector<int> goalPos_;
+    std::vector<char> locked_;
+    std::vector<unsigned> stamp_;
+    std::vector<int> parent_;
+    std::vector<int> queue_;
+    unsigned round_ = 0;
+    int blank_ = 0;
+    bool transposed_ = false;
+    std::vector<int> moves_;
+    std::vector<int> finish_;
+    size_t macroMoves_ = 0;
+    long long residualNodes_ = 0;
+    int residualSide_ = 0;
+    const std::vector<int>* residualRow_ = nullptr;
+    const std::vector<int>* residualCol_ = nullptr;
+};
+
+#endif
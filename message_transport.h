@@ -0,0 +1,428 @@
+/**
+ * @file message_transport.h
+ * @brief Message passing between the worker processes of a distributed search
+ *
+ * A Transport moves tagged batches of 64-bit words between P ranks. Messages
+ * between two given ranks arrive in the order they were sent; that is the
+ * only ordering the searches rely on. Two backends are provided:
+ *
+ *   - SocketTransport: a full mesh of Unix socketpairs between processes
+ *     forked on the local host (forkLocalWorkers). Sends never block on a
+ *     full socket without draining the incoming side, so two ranks sending
+ *     large batches to each other cannot deadlock.
+ *   - MpiTransport (compiled with -DPUZZLE_WITH_MPI): nonblocking MPI sends
+ *     and probed receives, for runs spread over several hosts with mpirun.
+ *
+ * RoundExchange builds bulk-synchronous rounds on top of a Transport: items
+ * for other ranks are buffered and sent in batches, and finish() sends every
+ * peer an end-of-round marker carrying a few counters, then returns the
+ * counters of all ranks once every peer's marker has arrived.
+ */
+#ifndef MESSAGE_TRANSPORT_H
+#define MESSAGE_TRANSPORT_H
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#ifdef PUZZLE_WITH_MPI
+#include <mpi.h>
+#endif
+
+struct Message {
+    int from = -1;
+    int tag = 0;
+    std::vector<uint64_t> data;
+};
+
+class Transport {
+public:
+    /**
+     * @brief Tag of the message a backend delivers when a peer goes away
+     */
+    static const int TAG_CLOSED = -1;
+
+    virtual ~Transport() = default;
+    virtual int rank() const = 0;
+    virtual int size() const = 0;
+    virtual void send(int peer, int tag, const uint64_t* data, size_t count) = 0;
+
+    /**
+     * @brief Next message from any peer; blocks when `wait`, otherwise false if none is ready
+     */
+    virtual bool receive(Message& message, bool wait) = 0;
+};
+
+/**
+ * @brief Rank connected to every other rank through one stream socket each
+ */
+class SocketTransport : public Transport {
+public:
+    /**
+     * @brief Takes ownership of `fds`, where fds[p] is the socket to rank p (-1 for self)
+     */
+    SocketTransport(int rank, std::vector<int> fds)
+        : rank_(rank), fds_(std::move(fds)), incoming_(fds_.size()), closed_(fds_.size()) {
+        for (int fd : fds_)
+            if (fd >= 0) fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    }
+
+    ~SocketTransport() override {
+        for (int fd : fds_)
+            if (fd >= 0) close(fd);
+    }
+
+    int rank() const override { return rank_; }
+    int size() const override { return (int)fds_.size(); }
+
+    void send(int peer, int tag, const uint64_t* data, size_t count) override {
+        uint32_t header[2] = {(uint32_t)tag, (uint32_t)count};
+        std::string bytes((const char*)header, sizeof(header));
+        bytes.append((const char*)data, count * sizeof(uint64_t));
+        size_t sent = 0;
+        while (sent < bytes.size()) {
+            ssize_t n = ::send(fds_[peer], bytes.data() + sent, bytes.size() - sent, MSG_NOSIGNAL);
+            if (n > 0) {
+                sent += (size_t)n;
+            } else if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                throw std::runtime_error("envío al proceso " + std::to_string(peer) + " fallido: " + strerror(errno));
+            } else {
+                pump(peer, -1);
+            }
+        }
+    }
+
+    bool receive(Message& message, bool wait) override {
+        while (inbox_.empty()) {
+            if (wait && std::count(closed_.begin(), closed_.end(), true) == size() - 1)
+                throw std::runtime_error("no queda ningún proceso conectado");
+            if (!pump(-1, wait ? -1 : 0) && !wait) return false;
+        }
+        message = std::move(inbox_.front());
+        inbox_.pop_front();
+        return true;
+    }
+
+private:
+    /**
+     * @brief Reads whatever is available into the inbox, waiting up to timeoutMs
+     *
+     * When `writable` is a peer, also returns as soon as its socket accepts
+     * more bytes. True when something was read.
+     */
+    bool pump(int writable, int timeoutMs) {
+        std::vector<pollfd> polls;
+        std::vector<int> peers;
+        for (int p = 0; p < size(); p++) {
+            if (p == rank_ || closed_[p]) continue;
+            polls.push_back({fds_[p], (short)(POLLIN | (p == writable ? POLLOUT : 0)), 0});
+            peers.push_back(p);
+        }
+        int ready = poll(polls.data(), polls.size(), timeoutMs);
+        if (ready < 0 && errno != EINTR) throw std::runtime_error(std::string("poll: ") + strerror(errno));
+        bool read = false;
+        char buffer[1 << 16];
+        for (size_t i = 0; ready > 0 && i < polls.size(); i++) {
+            if (!(polls[i].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+            ssize_t n = recv(polls[i].fd, buffer, sizeof(buffer), 0);
+            if (n == 0) {
+                closed_[peers[i]] = true;
+                Message closed;
+                closed.from = peers[i];
+                closed.tag = TAG_CLOSED;
+                inbox_.push_back(std::move(closed));
+                read = true;
+                continue;
+            }
+            if (n < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) continue;
+                throw std::runtime_error(std::string("recv: ") + strerror(errno));
+            }
+            incoming_[peers[i]].append(buffer, (size_t)n);
+            parse(peers[i]);
+            read = true;
+        }
+        return read;
+    }
+
+    void parse(int peer) {
+        std::string& bytes = incoming_[peer];
+        size_t offset = 0;
+        while (bytes.size() - offset >= 2 * sizeof(uint32_t)) {
+            uint32_t header[2];
+            memcpy(header, bytes.data() + offset, sizeof(header));
+            size_t length = sizeof(header) + (size_t)header[1] * sizeof(uint64_t);
+            if (bytes.size() - offset < length) break;
+            Message message;
+            message.from = peer;
+            message.tag = (int)header[0];
+            message.data.resize(header[1]);
+            memcpy(message.data.data(), bytes.data() + offset + sizeof(header), header[1] * sizeof(uint64_t));
+            inbox_.push_back(std::move(message));
+            offset += length;
+        }
+        bytes.erase(0, offset);
+    }
+
+    int rank_;
+    std::vector<int> fds_;
+    std::vector<std::string> incoming_;
+    std::vector<bool> closed_;
+    std::deque<Message> inbox_;
+};
+
+/**
+ * @brief Forks workers - 1 children connected by a socketpair mesh
+ *
+ * Returns the transport of the calling process: rank 0 in the parent and
+ * ranks 1..workers-1 in the children, which continue from the same point.
+ * The parent collects its children with waitLocalWorkers().
+ */
+inline std::unique_ptr<Transport> forkLocalWorkers(int workers, std::vector<pid_t>& children) {
+    std::vector<std::vector<int>> fds(workers, std::vector<int>(workers, -1));
+    for (int a = 0; a < workers; a++) {
+        for (int b = a + 1; b < workers; b++) {
+            int pair[2];
+            if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) != 0)
+                throw std::runtime_error(std::string("socketpair: ") + strerror(errno));
+            fds[a][b] = pair[0];
+            fds[b][a] = pair[1];
+        }
+    }
+    int rank = 0;
+    for (int r = 1; r < workers; r++) {
+        pid_t pid = fork();
+        if (pid < 0) throw std::runtime_error(std::string("fork: ") + strerror(errno));
+        if (pid == 0) {
+            rank = r;
+            children.clear();
+            break;
+        }
+        children.push_back(pid);
+    }
+    for (int a = 0; a < workers; a++) {
+        if (a == rank) continue;
+        for (int b = 0; b < workers; b++)
+            if (fds[a][b] >= 0) close(fds[a][b]);
+    }
+    return std::unique_ptr<Transport>(new SocketTransport(rank, fds[rank]));
+}
+
+/**
+ * @brief Waits for the children of forkLocalWorkers; true when all exited cleanly
+ */
+inline bool waitLocalWorkers(const std::vector<pid_t>& children) {
+    bool ok = true;
+    for (pid_t pid : children) {
+        int status = 0;
+        if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) ok = false;
+    }
+    return ok;
+}
+
+#ifdef PUZZLE_WITH_MPI
+/**
+ * @brief Transport over MPI_COMM_WORLD; MPI must already be initialized
+ */
+class MpiTransport : public Transport {
+public:
+    MpiTransport() {
+        MPI_Comm_rank(MPI_COMM_WORLD, &rank_);
+        MPI_Comm_size(MPI_COMM_WORLD, &size_);
+    }
+
+    ~MpiTransport() override {
+        while (!pending_.empty()) complete(true);
+    }
+
+    int rank() const override { return rank_; }
+    int size() const override { return size_; }
+
+    void send(int peer, int tag, const uint64_t* data, size_t count) override {
+        pending_.emplace_back();
+        Pending& p = pending_.back();
+        p.data.assign(data, data + count);
+        MPI_Isend(p.data.data(), (int)count, MPI_UINT64_T, peer, tag, MPI_COMM_WORLD, &p.request);
+        complete(false);
+    }
+
+    bool receive(Message& message, bool wait) override {
+        MPI_Status status;
+        int ready = 0;
+        while (true) {
+            MPI_Iprobe(MPI_ANY_SOURCE, MPI_ANY_TAG, MPI_COMM_WORLD, &ready, &status);
+            if (ready) break;
+            complete(false);
+            if (!wait) return false;
+        }
+        int count = 0;
+        MPI_Get_count(&status, MPI_UINT64_T, &count);
+        message.from = status.MPI_SOURCE;
+        message.tag = status.MPI_TAG;
+        message.data.resize(count);
+        MPI_Recv(message.data.data(), count, MPI_UINT64_T, status.MPI_SOURCE, status.MPI_TAG, MPI_COMM_WORLD,
+                 MPI_STATUS_IGNORE);
+        return true;
+    }
+
+private:
+    struct Pending {
+        std::vector<uint64_t> data;
+        MPI_Request request;
+    };
+
+    /**
+     * @brief Releases the buffers of finished sends (only the oldest when `all` is false)
+     */
+    void complete(bool all) {
+        while (!pending_.empty()) {
+            int done = 0;
+            if (all) {
+                MPI_Wait(&pending_.front().request, MPI_STATUS_IGNORE);
+                done = 1;
+            } else {
+                MPI_Test(&pending_.front().request, &done, MPI_STATUS_IGNORE);
+            }
+            if (!done) return;
+            pending_.pop_front();
+        }
+    }
+
+    int rank_ = 0;
+    int size_ = 1;
+    std::deque<Pending> pending_;
+};
+#endif
+
+/**
+ * @brief Batched all-to-all traffic in synchronous rounds
+ *
+ * The payload is a stream of fixed-size items of `itemWords` words. Every
+ * rank calls add() for the items owned by other ranks and poll() now and then
+ * to consume what has arrived; finish() closes the round. A peer that has
+ * finished a round may already be sending items of the next one: they are
+ * kept aside and handed out in the next round.
+ */
+class RoundExchange {
+public:
+    static const int TAG_ITEMS = 1;
+    static const int TAG_END = 2;
+
+    RoundExchange(Transport& transport, size_t itemWords, size_t batchItems)
+        : transport_(transport), itemWords_(itemWords), batchWords_(itemWords * batchItems),
+          outbox_(transport.size()), ended_(transport.size()) {}
+
+    int rank() const { return transport_.rank(); }
+    int size() const { return transport_.size(); }
+
+    void add(int peer, const uint64_t* item) {
+        std::vector<uint64_t>& box = outbox_[peer];
+        box.insert(box.end(), item, item + itemWords_);
+        if (box.size() >= batchWords_) flush(peer);
+    }
+
+    /**
+     * @brief Hands every item that arrived for this round to handle(const uint64_t*)
+     */
+    template <class Handler>
+    void poll(Handler handle) {
+        takeEarly(handle);
+        Message message;
+        while (transport_.receive(message, false)) dispatch(message, handle);
+    }
+
+    /**
+     * @brief Ends the round; returns counters[rank][i] for every rank
+     */
+    template <class Handler>
+    std::vector<std::vector<long long>> finish(const std::vector<long long>& counters, Handler handle) {
+        int size = transport_.size(), self = transport_.rank();
+        std::vector<uint64_t> packed(counters.begin(), counters.end());
+        for (int p = 0; p < size; p++) {
+            if (p == self) continue;
+            flush(p);
+            transport_.send(p, TAG_END, packed.data(), packed.size());
+        }
+        takeEarly(handle);
+        std::vector<std::vector<long long>> all(size);
+        all[self] = counters;
+        for (int p = 0; p < size; p++) ended_[p] = p == self;
+        waitingFor_ = size - 1;
+        std::vector<Message> held;
+        held.swap(held_);
+        for (Message& message : held) end(message, all);
+        Message message;
+        while (waitingFor_ > 0) {
+            transport_.receive(message, true);
+            if (message.tag == TAG_END && !ended_[message.from]) end(message, all);
+            else dispatch(message, handle);
+        }
+        return all;
+    }
+
+private:
+    void flush(int peer) {
+        std::vector<uint64_t>& box = outbox_[peer];
+        if (box.empty()) return;
+        transport_.send(peer, TAG_ITEMS, box.data(), box.size());
+        box.clear();
+    }
+
+    void end(const Message& message, std::vector<std::vector<long long>>& all) {
+        ended_[message.from] = true;
+        all[message.from].assign(message.data.begin(), message.data.end());
+        waitingFor_--;
+    }
+
+    template <class Handler>
+    void deliver(const Message& message, Handler& handle) {
+        for (size_t i = 0; i + itemWords_ <= message.data.size(); i += itemWords_) handle(&message.data[i]);
+    }
+
+    /**
+     * @brief Items kept during the previous finish() belong to the current round
+     */
+    template <class Handler>
+    void takeEarly(Handler& handle) {
+        for (const Message& message : early_) deliver(message, handle);
+        early_.clear();
+    }
+
+    template <class Handler>
+    void dispatch(Message& message, Handler& handle) {
+        if (message.tag == Transport::TAG_CLOSED) {
+            // Only a peer that already ended the last round may leave.
+            if (waitingFor_ == 0 || !ended_[message.from])
+                throw std::runtime_error("el proceso " + std::to_string(message.from) + " terminó antes de tiempo");
+        } else if (message.tag == TAG_END) {
+            // A peer already ended the next round; its marker is counted by the next finish().
+            held_.push_back(std::move(message));
+        } else if (waitingFor_ > 0 && ended_[message.from]) {
+            early_.push_back(std::move(message));
+        } else {
+            deliver(message, handle);
+        }
+    }
+
+    Transport& transport_;
+    size_t itemWords_;
+    size_t batchWords_;
+    std::vector<std::vector<uint64_t>> outbox_;
+    std::vector<bool> ended_;
+    std::deque<Message> early_;
+    std::vector<Message> held_;
+    int waitingFor_ = 0;
+};
+
+#endif
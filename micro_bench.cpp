@@ -0,0 +1,407 @@
+/**
+ * @file micro_bench.cpp
+ * @brief Microbenchmarks of the search primitives, one kernel at a time
+ *
+ * Times the building blocks the solvers spend their time in, away from the
+ * heap, the threads and the I/O of a whole search:
+ *
+ *   swap            copy a board and swap the blank with a neighbour (swapBoardTiles)
+ *   moves           legal moves of a board from MoveTable and every child board
+ *   h1              misplaced tiles, full evaluation (heuristic_kernels.h)
+ *   h2              Manhattan distance, full evaluation (heuristic_kernels.h)
+ *   visited_insert  insert distinct boards into a fresh unordered_set
+ *   visited_lookup  find in a filled unordered_set, half hits and half misses
+ *   closed_insert   insert into ClosedList (compact_closed_list.h), 4x4 only
+ *   expand_soa      BatchExpander over a packed frontier (frontier_batch.h), 4x4 only
+ *
+ * Boards come from random walks from the goal (--walk moves, 2 * cells by
+ * default, never undoing the previous move), so the heuristics and the hash
+ * sets see the kind of boards a search meets. Every kernel runs over a pool
+ * of distinct boards, cycling through it.
+ *
+ * For every kernel the operation count is doubled until one repetition lasts
+ * --min-time milliseconds; then two untimed warm-up repetitions run and
+ * --repeats timed ones. The report gives the median, the minimum, the mean
+ * and the standard deviation in ns per operation and the throughput of the
+ * median in millions of operations per second.
+ *
+ * With --compare the medians are checked against an earlier --format csv
+ * report; a kernel slower by more than --tolerance percent is reported as a
+ * regression and the exit status is 1. PUZZLE_SIMD caps the heuristic
+ * kernels (see heuristic_kernels.h) to compare their code paths.
+ *
+ * Compilation:
+ *      g++ -std=c++17 -O2 -o micro_bench micro_bench.cpp
+ *
+ * Usage:
+ *      ./micro_bench [--sizes 4,8,16,32] [--walk <movimientos>] [--repeats <n>] [--min-time <ms>]
+ *                    [--filter <texto>] [--format text|jsonl|csv] [--compare <informe.csv>] [--tolerance <pct>]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include "puzzle_tiles.h"
+#include "heuristic_kernels.h"
+#include "move_table.h"
+#include "compact_closed_list.h"
+#include "frontier_batch.h"
+#include "move_replay.h"
+#include "result_writer.h"
+
+using namespace std;
+using Clock = chrono::steady_clock;
+
+const size_t POOL_BOARDS = 4096;
+
+struct BenchOptions {
+    vector<int> sides = {4, 8, 16, 32};
+    int walk = 0;  // 0 = 2 * cells
+    int repeats = 15;
+    double minMillis = 20;
+    string filter;
+    OutputFormat format = FORMAT_TEXT;
+    string comparePath;
+    double tolerance = 10;
+};
+
+struct BenchResult {
+    string name;
+    int side;
+    long long ops;
+    double median;
+    double min;
+    double mean;
+    double stddev;
+};
+
+volatile long long benchSink;
+
+long long elapsedNanos(Clock::time_point start) {
+    return chrono::duration_cast<chrono::nanoseconds>(Clock::now() - start).count();
+}
+
+/**
+ * @brief Calibrates, warms up and repeats `run`, which returns the nanoseconds it spent on `ops` operations
+ */
+template <class Run>
+BenchResult measure(const string& name, int side, const BenchOptions& options, long long ops, Run run) {
+    while (run(ops) < options.minMillis * 1e6 && ops < (1LL << 40)) ops *= 2;
+    for (int i = 0; i < 2; i++) run(ops);
+
+    vector<double> samples;
+    for (int i = 0; i < options.repeats; i++) samples.push_back((double)run(ops) / (double)ops);
+    sort(samples.begin(), samples.end());
+
+    BenchResult result{name, side, ops, samples[samples.size() / 2], samples.front(), 0, 0};
+    for (double s : samples) result.mean += s;
+    result.mean /= (double)samples.size();
+    for (double s : samples) result.stddev += (s - result.mean) * (s - result.mean);
+    result.stddev = samples.size() > 1 ? sqrt(result.stddev / (double)(samples.size() - 1)) : 0;
+    return result;
+}
+
+template <class Board>
+Board swapBoardTiles(const Board& currentBoard, int position1, int position2) {
+    Board newBoard = currentBoard;
+    swap(newBoard[position1], newBoard[position2]);
+    return newBoard;
+}
+
+/**
+ * @brief Pool of distinct random-walk boards of one size
+ */
+template <class Board>
+struct Workload {
+    int side;
+    Board goal;
+    GoalTable table;
+    MoveTable moves;
+    vector<Board> boards;
+    vector<int> blanks;
+    vector<Board> absent;  // same boards with two tiles exchanged: never reachable, never in the pool
+
+    Workload(int boardSide, int walk, mt19937_64& random)
+        : side(boardSide), goal(toBoard<Board>(canonicalGoalTiles(boardSide))),
+          table(canonicalGoalTiles(boardSide), boardSide), moves(boardSide) {
+        unordered_set<Board> seen;
+        while (boards.size() < POOL_BOARDS) {
+            Board board = goal;
+            int blank = side * side - 1, last = -1;
+            for (int step = 0; step < walk; step++) {
+                int move;
+                do {
+                    move = (int)(random() % 4);
+                } while (moves.target(blank, move) < 0 || (last >= 0 && move == (last ^ 1)));
+                int next = moves.target(blank, move);
+                swap(board[blank], board[next]);
+                blank = next;
+                last = move;
+            }
+            if (!seen.insert(board).second) continue;
+            boards.push_back(board);
+            blanks.push_back(blank);
+            int first = blank == 0 ? 1 : 0, second = blank <= 1 ? 2 : 1;
+            absent.push_back(swapBoardTiles(board, first, second));
+        }
+    }
+};
+
+template <class Board>
+void benchSide(int side, const BenchOptions& options, vector<BenchResult>& results) {
+    mt19937_64 random(side);
+    int walk = options.walk > 0 ? options.walk : 2 * side * side;
+    Workload<Board> w(side, walk, random);
+    const size_t mask = POOL_BOARDS - 1;
+    auto wanted = [&](const string& name) { return options.filter.empty() || name.find(options.filter) != string::npos; };
+
+    if (wanted("swap")) {
+        results.push_back(measure("swap", side, options, POOL_BOARDS, [&](long long ops) {
+            long long sum = 0;
+            Clock::time_point start = Clock::now();
+            for (long long i = 0; i < ops; i++) {
+                size_t k = (size_t)i & mask;
+                int blank = w.blanks[k];
+                int next = w.moves.target(blank, blank >= side ? 0 : 1);
+                Board child = swapBoardTiles(w.boards[k], blank, next);
+                sum += tileAt(child[blank]);
+            }
+            long long nanos = elapsedNanos(start);
+            benchSink = sum;
+            return nanos;
+        }));
+    }
+
+    if (wanted("moves")) {
+        results.push_back(measure("moves", side, options, POOL_BOARDS, [&](long long ops) {
+            long long sum = 0;
+            Clock::time_point start = Clock::now();
+            for (long long i = 0; i < ops; i++) {
+                size_t k = (size_t)i & mask;
+                int blank = w.blanks[k];
+                uint8_t legal = w.moves.mask(blank);
+                for (int move = 0; move < 4; move++) {
+                    if (!(legal & (1 << move))) continue;
+                    int next = w.moves.target(blank, move);
+                    Board child = swapBoardTiles(w.boards[k], blank, next);
+                    sum += tileAt(child[blank]);
+                }
+            }
+            long long nanos = elapsedNanos(start);
+            benchSink = sum;
+            return nanos;
+        }));
+    }
+
+    if (wanted("h1")) {
+        results.push_back(measure("h1", side, options, POOL_BOARDS, [&](long long ops) {
+            long long sum = 0;
+            Clock::time_point start = Clock::now();
+            for (long long i = 0; i < ops; i++) sum += misplacedTiles(w.boards[(size_t)i & mask], w.goal);
+            long long nanos = elapsedNanos(start);
+            benchSink = sum;
+            return nanos;
+        }));
+    }
+
+    if (wanted("h2")) {
+        results.push_back(measure("h2", side, options, POOL_BOARDS, [&](long long ops) {
+            long long sum = 0;
+            Clock::time_point start = Clock::now();
+            for (long long i = 0; i < ops; i++) sum += manhattanDistance(w.boards[(size_t)i & mask], w.table);
+            long long nanos = elapsedNanos(start);
+            benchSink = sum;
+            return nanos;
+        }));
+    }
+
+    // The set benchmarks time whole passes over the pool; building and
+    // destroying the set stay outside the clock.
+    if (wanted("visited_insert")) {
+        results.push_back(measure("visited_insert", side, options, POOL_BOARDS, [&](long long ops) {
+            long long nanos = 0, sum = 0;
+            for (long long done = 0; done < ops; done += (long long)POOL_BOARDS) {
+                unordered_set<Board> visited;
+                Clock::time_point start = Clock::now();
+                for (const Board& board : w.boards) sum += visited.insert(board).second;
+                nanos += elapsedNanos(start);
+            }
+            benchSink = sum;
+            return nanos;
+        }));
+    }
+
+    if (wanted("visited_lookup")) {
+        unordered_set<Board> visited(w.boards.begin(), w.boards.end());
+        results.push_back(measure("visited_lookup", side, options, POOL_BOARDS, [&](long long ops) {
+            long long sum = 0;
+            Clock::time_point start = Clock::now();
+            for (long long i = 0; i < ops; i++) {
+                size_t k = (size_t)i & mask;
+                sum += visited.count((i & 1) ? w.absent[k] : w.boards[k]);
+            }
+            long long nanos = elapsedNanos(start);
+            benchSink = sum;
+            return nanos;
+        }));
+    }
+
+    if (side * side <= (int)COMPACT_MAX_CELLS && wanted("closed_insert")) {
+        results.push_back(measure("closed_insert", side, options, POOL_BOARDS, [&](long long ops) {
+            long long nanos = 0, sum = 0;
+            for (long long done = 0; done < ops; done += (long long)POOL_BOARDS) {
+                ClosedList<Board> closed(side * side);
+                Clock::time_point start = Clock::now();
+                for (const Board& board : w.boards) sum += closed.insert(board);
+                nanos += elapsedNanos(start);
+            }
+            benchSink = sum;
+            return nanos;
+        }));
+    }
+
+    if (side == 4 && wanted("expand_soa")) {
+        auto manhattanTerm = [&](int tile, int cell) {
+            return abs(cell / 4 - w.table.row[tile]) + abs(cell % 4 - w.table.col[tile]);
+        };
+        BatchExpander expander(manhattanTerm);
+        FrontierBatch parents, children;
+        vector<uint8_t> legal;
+        for (size_t k = 0; k < POOL_BOARDS; k++) {
+            uint64_t packed = packBoard16(fromBoard(w.boards[k]));
+            parents.push(packed, w.blanks[k], 0, BatchExpander::evaluate(packed, manhattanTerm));
+        }
+        const size_t slice = 64;
+        results.push_back(measure("expand_soa", side, options, POOL_BOARDS, [&](long long ops) {
+            long long sum = 0;
+            Clock::time_point start = Clock::now();
+            for (long long i = 0; i < ops; i += (long long)slice) {
+                size_t begin = (size_t)i & mask;
+                expander.expand(parents, begin, begin + slice, children, legal);
+                sum += children.heuristic[0] + legal[slice - 1];
+            }
+            long long nanos = elapsedNanos(start);
+            benchSink = sum;
+            return nanos;
+        }));
+    }
+}
+
+/**
+ * @brief Medians of an earlier CSV report, keyed by "kernel/side"
+ */
+bool readBaseline(const string& path, map<string, double>& baseline) {
+    ifstream in(path);
+    if (!in) return false;
+    string line;
+    getline(in, line);
+    while (getline(in, line)) {
+        stringstream fields(line);
+        string name, side, ops, median;
+        if (getline(fields, name, ',') && getline(fields, side, ',') && getline(fields, ops, ',') && getline(fields, median, ','))
+            baseline[name + "/" + side] = stod(median);
+    }
+    return true;
+}
+
+void report(const vector<BenchResult>& results, OutputFormat format) {
+    if (format == FORMAT_CSV) {
+        printf("kernel,side,ops,median_ns,min_ns,mean_ns,stddev_ns,mops\n");
+        for (const BenchResult& r : results)
+            printf("%s,%d,%lld,%.3f,%.3f,%.3f,%.3f,%.3f\n", r.name.c_str(), r.side, r.ops, r.median, r.min, r.mean, r.stddev,
+                   1e3 / r.median);
+        return;
+    }
+    if (format == FORMAT_JSONL) {
+        for (const BenchResult& r : results)
+            printf("{\"kernel\":\"%s\",\"side\":%d,\"ops\":%lld,\"median_ns\":%.3f,\"min_ns\":%.3f,\"mean_ns\":%.3f,"
+                   "\"stddev_ns\":%.3f,\"mops\":%.3f}\n",
+                   r.name.c_str(), r.side, r.ops, r.median, r.min, r.mean, r.stddev, 1e3 / r.median);
+        return;
+    }
+    printf("%-16s %5s %14s %12s %20s %12s\n", "kernel", "lado", "ns/op mediana", "ns/op mín", "media ± desv", "Mops/s");
+    for (const BenchResult& r : results) {
+        char spread[64];
+        snprintf(spread, sizeof(spread), "%.2f ± %.2f", r.mean, r.stddev);
+        printf("%-16s %5d %14.2f %12.2f %20s %12.2f\n", r.name.c_str(), r.side, r.median, r.min, spread, 1e3 / r.median);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--sizes" && hasValue) {
+            options.sides.clear();
+            stringstream list(argv[++i]);
+            string item;
+            while (getline(list, item, ',')) {
+                int side = atoi(item.c_str());
+                if (side >= 3) options.sides.push_back(side);
+            }
+        } else if (arg == "--walk" && hasValue) {
+            options.walk = max(0, atoi(argv[++i]));
+        } else if (arg == "--repeats" && hasValue) {
+            options.repeats = max(1, atoi(argv[++i]));
+        } else if (arg == "--min-time" && hasValue) {
+            options.minMillis = max(0.1, atof(argv[++i]));
+        } else if (arg == "--filter" && hasValue) {
+            options.filter = argv[++i];
+        } else if (arg == "--format" && hasValue && parseOutputFormat(argv[i + 1], options.format)) {
+            i++;
+        } else if (arg == "--compare" && hasValue) {
+            options.comparePath = argv[++i];
+        } else if (arg == "--tolerance" && hasValue) {
+            options.tolerance = max(0.0, atof(argv[++i]));
+        } else {
+            cerr << "Uso: " << argv[0] << " [--sizes 4,8,16,32] [--walk <movimientos>] [--repeats <n>] [--min-time <ms>]"
+                 << " [--filter <texto>] [--format text|jsonl|csv] [--compare <informe.csv>] [--tolerance <pct>]" << endl;
+            return 1;
+        }
+    }
+    if (options.sides.empty()) {
+        cerr << "Error: --sizes no contiene ningún tamaño válido" << endl;
+        return 1;
+    }
+
+    map<string, double> baseline;
+    if (!options.comparePath.empty() && !readBaseline(options.comparePath, baseline)) {
+        cerr << "Error: no se pudo abrir " << options.comparePath << endl;
+        return 1;
+    }
+
+    if (options.format == FORMAT_TEXT)
+        printf("Nivel SIMD: %s, %d repeticiones de al menos %.1f ms\n\n", simdLevelName(simdLevel()), options.repeats,
+               options.minMillis);
+    vector<BenchResult> results;
+    for (int side : options.sides) {
+        if (usesWideTiles(side)) benchSide<u16string>(side, options, results);
+        else benchSide<string>(side, options, results);
+    }
+    report(results, options.format);
+
+    if (baseline.empty()) return 0;
+    int regressions = 0;
+    FILE* out = options.format == FORMAT_TEXT ? stdout : stderr;
+    fprintf(out, "\nComparación con %s (tolerancia %.1f%%):\n", options.comparePath.c_str(), options.tolerance);
+    for (const BenchResult& r : results) {
+        auto it = baseline.find(r.name + "/" + to_string(r.side));
+        if (it == baseline.end() || it->second <= 0) continue;
+        double change = (r.median / it->second - 1) * 100;
+        bool regressed = change > options.tolerance;
+        regressions += regressed;
+        fprintf(out, "%-16s %5d %10.2f -> %10.2f ns/op %+7.1f%%%s\n", r.name.c_str(), r.side, it->second, r.median, change,
+                regressed ? "  REGRESIÓN" : "");
+    }
+    return regressions > 0 ? 1 : 0;
+}
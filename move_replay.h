@@ -0,0 +1,141 @@
+/**
+ * @file move_replay.h
+ * @brief Fast replay and validation of move sequences
+ *
+ * Moves are blank moves in the order of the solvers' dRow / dCol tables:
+ * 0 UP, 1 DOWN, 2 LEFT, 3 RIGHT. A replay keeps the blank index, so every move
+ * is one MoveTable lookup and one swap in a flat tile array. 4x4 boards can also
+ * be replayed packed in a single uint64 (one nibble per cell).
+ *
+ * Sequences are read either compact ("UULDR...") or as names separated by
+ * commas or spaces ("UP,UP,LEFT"); "-" is the empty sequence.
+ */
+#ifndef MOVE_REPLAY_H
+#define MOVE_REPLAY_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "puzzle_tiles.h"
+#include "move_table.h"
+
+const int MOVE_UP = 0;
+const int MOVE_DOWN = 1;
+const int MOVE_LEFT = 2;
+const int MOVE_RIGHT = 3;
+
+/**
+ * @brief Outcome of replaying one sequence
+ *
+ * firstIllegal is the index of the first move that would push the blank off
+ * the board (-1 when every move is legal); the replay stops there, so
+ * `applied` moves were played and `reachedGoal` describes that state.
+ */
+struct ReplayResult {
+    bool reachedGoal = false;
+    long long firstIllegal = -1;
+    long long applied = 0;
+};
+
+inline int parseMoveName(const std::string& name) {
+    if (name == "UP" || name == "U") return MOVE_UP;
+    if (name == "DOWN" || name == "D") return MOVE_DOWN;
+    if (name == "LEFT" || name == "L") return MOVE_LEFT;
+    if (name == "RIGHT" || name == "R") return MOVE_RIGHT;
+    return -1;
+}
+
+/**
+ * @brief Parses a compact or named move sequence; false on an unknown move
+ */
+inline bool parseMoves(const std::string& text, std::vector<int>& moves) {
+    moves.clear();
+    if (text == "-") return true;
+    if (text.find_first_of(", ") == std::string::npos && text.find_first_not_of("UDLR") == std::string::npos) {
+        moves.reserve(text.size());
+        for (char c : text) moves.push_back(c == 'U' ? MOVE_UP : c == 'D' ? MOVE_DOWN : c == 'L' ? MOVE_LEFT : MOVE_RIGHT);
+        return true;
+    }
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t end = text.find_first_of(", ", pos);
+        if (end == std::string::npos) end = text.size();
+        if (end > pos) {
+            int move = parseMoveName(text.substr(pos, end - pos));
+            if (move < 0) return false;
+            moves.push_back(move);
+        }
+        pos = end + 1;
+    }
+    return true;
+}
+
+/**
+ * @brief Destination of the blank for a move, or -1 when it leaves the board
+ */
+inline int movedBlank(int blank, int move, int side) {
+    switch (move) {
+        case MOVE_UP: return blank >= side ? blank - side : -1;
+        case MOVE_DOWN: return blank < side * (side - 1) ? blank + side : -1;
+        case MOVE_LEFT: return blank % side > 0 ? blank - 1 : -1;
+        case MOVE_RIGHT: return blank % side < side - 1 ? blank + 1 : -1;
+        default: return -1;
+    }
+}
+
+/**
+ * @brief Plays `moves` on a flat board in place, tracking the blank
+ */
+template <class Cell>
+inline ReplayResult replayMoves(std::vector<Cell>& board, const MoveTable& table, const std::vector<int>& moves,
+                                const std::vector<Cell>& goal) {
+    ReplayResult result;
+    int blank = blankPosition(board);
+    for (size_t i = 0; i < moves.size(); i++) {
+        int next = table.target(blank, moves[i]);
+        if (next < 0) {
+            result.firstIllegal = (long long)i;
+            break;
+        }
+        board[blank] = board[next];
+        board[next] = BLANK_TILE;
+        blank = next;
+        result.applied++;
+    }
+    result.reachedGoal = board == goal;
+    return result;
+}
+
+/**
+ * @brief 4x4 board packed one tile ID per nibble, cell 0 in the low nibble
+ */
+inline uint64_t packBoard16(const std::vector<uint16_t>& tiles) {
+    uint64_t packed = 0;
+    for (int i = 0; i < 16; i++) packed |= (uint64_t)(tiles[i] & 0xF) << (4 * i);
+    return packed;
+}
+
+/**
+ * @brief Same as replayMoves for a packed 4x4 board: one shift/mask pair per move
+ */
+inline ReplayResult replayMovesPacked16(uint64_t& board, const MoveTable& table, const std::vector<int>& moves,
+                                        uint64_t goal) {
+    ReplayResult result;
+    int blank = 0;
+    while ((board >> (4 * blank)) & 0xF) blank++;
+    for (size_t i = 0; i < moves.size(); i++) {
+        int next = table.target(blank, moves[i]);
+        if (next < 0) {
+            result.firstIllegal = (long long)i;
+            break;
+        }
+        uint64_t tile = (board >> (4 * next)) & 0xF;
+        board = (board & ~(0xFULL << (4 * next))) | (tile << (4 * blank));
+        blank = next;
+        result.applied++;
+    }
+    result.reachedGoal = board == goal;
+    return result;
+}
+
+#endif
@@ -0,0 +1,73 @@
+/**
+ * @file move_table.h
+ * @brief Precomputed legal-move masks and blank destinations
+ *
+ * For a side x side board the legal blank moves depend only on the blank
+ * cell, so they are computed once per size: mask(blank) has bit m set when
+ * move m (0 UP, 1 DOWN, 2 LEFT, 3 RIGHT) keeps the blank on the board, and
+ * target(blank, m) is the cell the blank moves to (-1 when illegal).
+ *
+ * The batch forms fill the masks of many boards at once from a flat array
+ * of boards stored back to back (side * side cells each).
+ */
+#ifndef MOVE_TABLE_H
+#define MOVE_TABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "puzzle_tiles.h"
+
+const uint8_t MOVE_MASK_UP = 1;
+const uint8_t MOVE_MASK_DOWN = 2;
+const uint8_t MOVE_MASK_LEFT = 4;
+const uint8_t MOVE_MASK_RIGHT = 8;
+
+class MoveTable {
+public:
+    explicit MoveTable(int side) : side_(side), masks_(side * side), targets_(4 * side * side) {
+        for (int cell = 0; cell < side * side; cell++) {
+            int row = cell / side, col = cell % side;
+            int next[4] = {row > 0 ? cell - side : -1, row < side - 1 ? cell + side : -1,
+                           col > 0 ? cell - 1 : -1, col < side - 1 ? cell + 1 : -1};
+            for (int move = 0; move < 4; move++) {
+                targets_[4 * cell + move] = next[move];
+                if (next[move] >= 0) masks_[cell] |= 1 << move;
+            }
+        }
+    }
+
+    int side() const { return side_; }
+
+    uint8_t mask(int blank) const { return masks_[blank]; }
+
+    int target(int blank, int move) const { return targets_[4 * blank + move]; }
+
+    /**
+     * @brief Masks for `count` blank positions
+     */
+    void masks(const int* blanks, size_t count, uint8_t* out) const {
+        for (size_t i = 0; i < count; i++) out[i] = masks_[blanks[i]];
+    }
+
+    /**
+     * @brief Masks for `count` boards stored back to back; 0 for a board without blank
+     */
+    template <class Cell>
+    void masks(const Cell* boards, size_t count, uint8_t* out) const {
+        const size_t cells = (size_t)side_ * side_;
+        for (size_t i = 0; i < count; i++) {
+            const Cell* board = boards + i * cells;
+            size_t blank = 0;
+            while (blank < cells && tileAt(board[blank]) != BLANK_TILE) blank++;
+            out[i] = blank < cells ? masks_[blank] : 0;
+        }
+    }
+
+private:
+    int side_;
+    std::vector<uint8_t> masks_;
+    std::vector<int> targets_;
+};
+
+#endif
@@ -0,0 +1,168 @@
+/**
+ * @file multi_queue.h
+ * @brief Relaxed concurrent priority queue (MultiQueue) and sharded g-value table
+ *
+ * A MultiQueue keeps c * p independent binary heaps, each behind its own
+ * lock. push() puts the element into a random heap; pop() peeks the tops of
+ * two random heaps (lock-free, through a cached key) and pops from the
+ * better one. Threads never wait on a shared lock, and the popped element is
+ * close to the global minimum with high probability, which is all a
+ * best-first search needs as long as it keeps expanding until no open node
+ * can improve the incumbent.
+ *
+ * size() counts elements from just before they are inserted until just after
+ * they are removed, so "size() == 0 and no thread holds a node" is a safe
+ * termination test.
+ */
+#ifndef MULTI_QUEUE_H
+#define MULTI_QUEUE_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Small per-thread random generator for queue selection
+ */
+struct QueueRandom {
+    uint64_t state;
+    explicit QueueRandom(uint64_t seed) : state(seed * 0x9E3779B97F4A7C15ULL + 1) {}
+    uint32_t next(uint32_t bound) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return (uint32_t)(state % bound);
+    }
+};
+
+/**
+ * @brief MultiQueue of T ordered by Compare (greater<T> gives a min-queue), keyed by key(T) for peeking
+ */
+template <class T, class Compare, class Key>
+class MultiQueue {
+public:
+    MultiQueue(int threads, int queuesPerThread, Key key)
+        : heaps_(std::max(2, threads * queuesPerThread)), key_(key) {}
+
+    void push(const T& value, QueueRandom& random) {
+        size_.fetch_add(1);
+        while (true) {
+            Heap& heap = heaps_[random.next(heaps_.size())];
+            if (!heap.lock.try_lock()) continue;
+            heap.items.push(value);
+            heap.top.store(key_(heap.items.top()), std::memory_order_relaxed);
+            heap.lock.unlock();
+            return;
+        }
+    }
+
+    /**
+     * @brief Pops a near-minimal element; false only when every heap was seen empty
+     */
+    bool tryPop(T& out, QueueRandom& random) {
+        for (int attempt = 0; attempt < 4; attempt++) {
+            Heap& a = heaps_[random.next(heaps_.size())];
+            Heap& b = heaps_[random.next(heaps_.size())];
+            Heap& best = b.top.load(std::memory_order_relaxed) < a.top.load(std::memory_order_relaxed) ? b : a;
+            if (best.top.load(std::memory_order_relaxed) == EMPTY) continue;
+            if (popFrom(best, out)) return true;
+        }
+        size_t start = random.next(heaps_.size());
+        for (size_t i = 0; i < heaps_.size(); i++) {
+            Heap& heap = heaps_[(start + i) % heaps_.size()];
+            if (heap.top.load(std::memory_order_relaxed) != EMPTY && popFrom(heap, out)) return true;
+        }
+        return false;
+    }
+
+    size_t size() const { return size_.load(); }
+
+    /**
+     * @brief Smallest key over all heap tops (a snapshot, for reporting)
+     */
+    double minKey() const {
+        double best = EMPTY;
+        for (const Heap& heap : heaps_) best = std::min(best, heap.top.load(std::memory_order_relaxed));
+        return best;
+    }
+
+    static constexpr double EMPTY = std::numeric_limits<double>::infinity();
+
+private:
+    struct Heap {
+        std::mutex lock;
+        std::priority_queue<T, std::vector<T>, Compare> items;
+        std::atomic<double> top{EMPTY};
+    };
+
+    bool popFrom(Heap& heap, T& out) {
+        std::lock_guard<std::mutex> guard(heap.lock);
+        if (heap.items.empty()) return false;
+        out = heap.items.top();
+        heap.items.pop();
+        heap.top.store(heap.items.empty() ? EMPTY : key_(heap.items.top()), std::memory_order_relaxed);
+        size_.fetch_sub(1);
+        return true;
+    }
+
+    std::vector<Heap> heaps_;
+    Key key_;
+    std::atomic<size_t> size_{0};
+};
+
+/**
+ * @brief Best known cost per board, split into independently locked shards
+ */
+class ShardedCostTable {
+public:
+    explicit ShardedCostTable(int shards) : shards_(shards) {}
+
+    /**
+     * @brief Records `cost` if it improves the stored one; true when it did
+     */
+    bool improve(const std::string& board, int cost) {
+        Shard& shard = shardFor(board);
+        std::lock_guard<std::mutex> guard(shard.lock);
+        auto it = shard.costs.find(board);
+        if (it != shard.costs.end()) {
+            if (it->second <= cost) return false;
+            it->second = cost;
+            return true;
+        }
+        shard.costs.emplace(board, cost);
+        size_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /**
+     * @brief True when `cost` is still the best known cost of `board`
+     */
+    bool isCurrent(const std::string& board, int cost) {
+        Shard& shard = shardFor(board);
+        std::lock_guard<std::mutex> guard(shard.lock);
+        auto it = shard.costs.find(board);
+        return it != shard.costs.end() && it->second == cost;
+    }
+
+    size_t size() const { return size_.load(std::memory_order_relaxed); }
+
+private:
+    struct Shard {
+        std::mutex lock;
+        std::unordered_map<std::string, int> costs;
+    };
+
+    Shard& shardFor(const std::string& board) { return shards_[std::hash<std::string>()(board) % shards_.size()]; }
+
+    std::vector<Shard> shards_;
+    std::atomic<size_t> size_{0};
+};
+
+#endif
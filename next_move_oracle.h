@@ -0,0 +1,191 @@
+/**
+ * @file next_move_oracle.h
+ * @brief Real-time next-move queries: bounded lookahead with LRTA* learning
+ *
+ * next() does not solve the board. It runs a minimin lookahead from the board
+ * with iterative deepening until the microsecond budget runs out and returns
+ * the first move of the best frontier path found by the deepest completed
+ * iteration. Depth 1 needs no clock reads, so there is always an answer.
+ *
+ * Frontier nodes are valued g + h, where h is the Manhattan distance or the
+ * learned estimate of that board when one exists, and no path is valued
+ * below g + estimate of any board on it. After each query the
+ * board's estimate is raised to the value of the chosen move (the LRTA*
+ * update). Estimates are shared by every caller and persist across queries,
+ * so a client that keeps asking from the boards it reaches cannot cycle
+ * forever: every revisit of a local minimum raises its estimate until the
+ * way out looks cheaper.
+ *
+ * Manhattan is consistent and learned estimates are never below it, so f
+ * does not decrease along a path and subtrees whose g + h already reaches the
+ * best frontier value (alpha) are pruned without changing the answer.
+ *
+ * Boards are strings of tile IDs (toBoard<string>) for any size the caller's
+ * GoalTable describes. Moves use the MOVE_* order: 0 UP, 1 DOWN, 2 LEFT, 3 RIGHT.
+ */
+#ifndef NEXT_MOVE_ORACLE_H
+#define NEXT_MOVE_ORACLE_H
+
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include "puzzle_tiles.h"
+#include "heuristic_kernels.h"
+
+class NextMoveOracle {
+public:
+    static const int MAX_LOOKAHEAD = 40;
+
+    struct Answer {
+        int move = -1;         // -1 when the board already is the goal
+        int estimate = 0;      // distance estimate of the board after learning
+        int depth = 0;         // deepest completed lookahead
+        long long nodes = 0;
+    };
+
+    explicit NextMoveOracle(size_t learnedLimit = 1 << 20) : learnedLimit_(learnedLimit) {}
+
+    Answer next(const std::string& board, const GoalTable& goal, long long budgetMicros) {
+        Search search(board, goal, *this, std::chrono::steady_clock::now() + std::chrono::microseconds(budgetMicros));
+        Answer answer;
+        int h = manhattanDistance(board, goal);
+        if (h == 0) return answer;
+
+        int blank = blankPosition(board);
+        int bestValue = INT_MAX;
+        {
+            std::shared_lock<std::shared_mutex> read(learnedMutex_);
+            for (int depth = 1; depth <= MAX_LOOKAHEAD; depth++) {
+                int alpha = INT_MAX, best = INT_MAX, move = -1;
+                for (int m = 0; m < 4 && !search.aborted; m++) {
+                    int value = search.child(blank, m, h, depth, alpha);
+                    if (value < best) {
+                        best = value;
+                        move = m;
+                    }
+                    if (value < alpha) alpha = value;
+                }
+                if (search.aborted) break;
+                answer.move = move;
+                answer.depth = depth;
+                bestValue = best;
+                // A value within the lookahead depth is a path that reaches the goal.
+                if (best <= depth) break;
+            }
+        }
+        answer.nodes = search.nodes;
+
+        std::unique_lock<std::shared_mutex> write(learnedMutex_);
+        auto it = learned_.find(board);
+        int estimate = std::max(it != learned_.end() ? it->second : h, bestValue);
+        if (it != learned_.end()) {
+            it->second = estimate;
+        } else {
+            if (learned_.size() >= learnedLimit_) learned_.clear();
+            learned_.emplace(board, estimate);
+        }
+        answer.estimate = estimate;
+        return answer;
+    }
+
+    size_t learnedStates() {
+        std::shared_lock<std::shared_mutex> read(learnedMutex_);
+        return learned_.size();
+    }
+
+private:
+    /**
+     * @brief One query's depth-first minimin; moves are applied in place and undone
+     */
+    struct Search {
+        std::string board;
+        const GoalTable& goal;
+        const NextMoveOracle& oracle;
+        std::chrono::steady_clock::time_point deadline;
+        long long nodes = 0;
+        bool aborted = false;
+
+        Search(const std::string& b, const GoalTable& g, const NextMoveOracle& o, std::chrono::steady_clock::time_point d)
+            : board(b), goal(g), oracle(o), deadline(d) {}
+
+        /**
+         * @brief Cell the blank moves to, or -1 when the move leaves the board
+         */
+        int target(int blank, int move) const {
+            int side = goal.side;
+            switch (move) {
+                case 0: return blank >= side ? blank - side : -1;
+                case 1: return blank < side * (side - 1) ? blank + side : -1;
+                case 2: return blank % side > 0 ? blank - 1 : -1;
+                default: return blank % side < side - 1 ? blank + 1 : -1;
+            }
+        }
+
+        /**
+         * @brief Value of moving the blank from `blank` in direction `move`, INT_MAX if illegal or pruned
+         */
+        int child(int blank, int move, int h, int depth, int& alpha) {
+            int next = target(blank, move);
+            if (next < 0) return INT_MAX;
+            int tile = tileAt(board[next]);
+            int before = std::abs(goal.cellRow[next] - goal.row[tile]) + std::abs(goal.cellCol[next] - goal.col[tile]);
+            int after = std::abs(goal.cellRow[blank] - goal.row[tile]) + std::abs(goal.cellCol[blank] - goal.col[tile]);
+            std::swap(board[blank], board[next]);
+            int value = minimin(next, h + after - before, 1, depth - 1, move ^ 1, 0, alpha);
+            std::swap(board[blank], board[next]);
+            return value;
+        }
+
+        /**
+         * @brief Best frontier value below the current board; `floor` is the largest g + estimate on the path
+         *
+         * Learned estimates bound interior boards too, so a path is worth at
+         * least the estimate of every board it crosses. Without that the
+         * boards next to the root would never feed their learning back.
+         */
+        int minimin(int blank, int h, int g, int depth, int reverse, int floor, int& alpha) {
+            if (h == 0) return g;
+            floor = std::max(floor, g + oracle.estimateOf(board, h));
+            if (floor >= alpha) return INT_MAX;
+            if (depth == 0) return floor;
+            if ((++nodes & 255) == 0 && std::chrono::steady_clock::now() > deadline) {
+                aborted = true;
+                return INT_MAX;
+            }
+            int best = INT_MAX;
+            for (int m = 0; m < 4 && !aborted; m++) {
+                if (m == reverse) continue;
+                int next = target(blank, m);
+                if (next < 0) continue;
+                int tile = tileAt(board[next]);
+                int before = std::abs(goal.cellRow[next] - goal.row[tile]) + std::abs(goal.cellCol[next] - goal.col[tile]);
+                int after = std::abs(goal.cellRow[blank] - goal.row[tile]) + std::abs(goal.cellCol[blank] - goal.col[tile]);
+                std::swap(board[blank], board[next]);
+                int value = minimin(next, h + after - before, g + 1, depth - 1, m ^ 1, floor, alpha);
+                std::swap(board[blank], board[next]);
+                if (value < best) best = value;
+                if (value < alpha) alpha = value;
+            }
+            return best;
+        }
+    };
+
+    /**
+     * @brief Learned estimate of a frontier board, or its Manhattan distance; caller holds the read lock
+     */
+    int estimateOf(const std::string& board, int h) const {
+        if (learned_.empty()) return h;
+        auto it = learned_.find(board);
+        return it != learned_.end() ? std::max(h, it->second) : h;
+    }
+
+    size_t learnedLimit_;
+    std::shared_mutex learnedMutex_;
+    std::unordered_map<std::string, int> learned_;
+};
+
+#endif
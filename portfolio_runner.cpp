@@ -0,0 +1,410 @@
+/**
+ * @file portfolio_runner.cpp
+ * @brief Races several solver engines on each board and keeps the first answer
+ *
+ * Which engine is fastest depends on the board: BFS is hard to beat on
+ * shallow boards, h2 on deep ones, and the OpenMP variants only pay off once
+ * the search is large. The runner starts every engine of the portfolio as
+ * its own process on the same board, reads their --format jsonl records and
+ * takes the first definitive answer, "solved" or "unsolvable". Every engine
+ * in the table is an exact search: BFS, or A* with w = 1 and a consistent
+ * heuristic, which closes boards on expansion (h1, h2) or reopens them when
+ * a shorter path turns up (the OpenMP ones). The runner never passes -w,
+ * and it passes --optimal to the sequential engines so they do not fall
+ * back to the macro solver, so whichever engine answers first, its cost is
+ * the optimum. The losers are then cancelled: each engine runs in its own
+ * process group and the whole group gets SIGKILL. An engine that runs out of budget simply drops out of the race,
+ * and so does one that rejects the board as "invalid"; the board is then
+ * reported invalid if no engine answers.
+ *
+ * Engines (binary looked up in --bin-dir, "name=path" overrides it):
+ *   bsp       bsp_puzzle_solver <n> --optimal
+ *   h1        h1_puzzle_solver <n> --optimal
+ *   h2        h2_puzzle_solver <n> --optimal
+ *   bsp_omp   bsp_omp   (4x4 only, skipped on other sizes)
+ *   h1_omp    h1_omp    (4x4 only)
+ *   h2_omp    h2_omp    (4x4 only)
+ * An engine added here must be exact too, or the race would report
+ * whichever answer came first rather than the optimum.
+ *
+ * The record of every board names the winning engine, and --log appends one
+ * CSV line per engine and board with its outcome (ganador, cancelado,
+ * presupuesto, inválido, error, omitido), which is the data needed to tune the
+ * portfolio for a given input mix.
+ *
+ * --time-limit, --max-nodes and --max-mem are passed to every engine;
+ * --omp-threads sets OMP_NUM_THREADS for the OpenMP ones so they do not
+ * oversubscribe the cores the sequential engines are using.
+ *
+ * Compilation:
+ *      g++ -std=c++17 -O2 -o portfolio_runner portfolio_runner.cpp
+ *
+ * Usage:
+ *      ./portfolio_runner [--engines h2,h1,bsp] [--bin-dir <dir>] [--size <n>] [--input <archivo>]
+ *                         [--format text|jsonl|csv] [--log <archivo.csv>] [--omp-threads <n>]
+ *                         [--time-limit <s>] [--max-nodes <n>] [--max-mem <MB>]
+ */
+
+#include <chrono>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "search_budget.h"
+#include "result_writer.h"
+#include "puzzle_set.h"
+
+using namespace std;
+using Clock = chrono::steady_clock;
+
+struct EngineSpec {
+    string name;
+    string binary;
+    bool openmp;  // 4x4 letter boards only, takes no size argument
+};
+
+const EngineSpec KNOWN_ENGINES[] = {
+    {"bsp", "bsp_puzzle_solver", false},
+    {"h1", "h1_puzzle_solver", false},
+    {"h2", "h2_puzzle_solver", false},
+    {"bsp_omp", "bsp_omp", true},
+    {"h1_omp", "h1_omp", true},
+    {"h2_omp", "h2_omp", true},
+};
+
+/**
+ * @brief One engine process racing on the current board
+ */
+struct Runner {
+    EngineSpec engine;
+    pid_t pid = -1;
+    int fd = -1;
+    string output;
+    string outcome;  // empty while running
+    int cost = 0;
+    double seconds = 0;
+};
+
+vector<Runner>* activeRunners = nullptr;
+char tempPath[] = "/tmp/portfolio_XXXXXX";
+
+/**
+ * @brief Takes the engines down with the runner when it is interrupted or its output is closed
+ */
+void cancelAll(int signalNumber) {
+    if (activeRunners) {
+        for (const Runner& runner : *activeRunners) {
+            if (runner.pid > 0) kill(-runner.pid, SIGKILL);
+        }
+    }
+    unlink(tempPath);
+    signal(signalNumber, SIG_DFL);
+    raise(signalNumber);
+}
+
+struct RaceResult {
+    int cost = BUDGET_EXCEEDED;
+    string engine;
+    double seconds = 0;
+};
+
+/**
+ * @brief Value of a numeric or string field of one flat jsonl record
+ */
+string jsonField(const string& line, const string& key) {
+    string pattern = "\"" + key + "\":";
+    size_t pos = line.find(pattern);
+    if (pos == string::npos) return "";
+    pos += pattern.size();
+    if (line[pos] == '"') {
+        size_t end = line.find('"', pos + 1);
+        return end == string::npos ? "" : line.substr(pos + 1, end - pos - 1);
+    }
+    size_t end = line.find_first_of(",}", pos);
+    return line.substr(pos, end == string::npos ? string::npos : end - pos);
+}
+
+bool startRunner(Runner& runner, const vector<string>& args, int ompThreads) {
+    int pipeFds[2];
+    if (pipe(pipeFds) != 0) return false;
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(pipeFds[0]);
+        close(pipeFds[1]);
+        return false;
+    }
+    if (pid == 0) {
+        setpgid(0, 0);
+        dup2(pipeFds[1], STDOUT_FILENO);
+        close(pipeFds[0]);
+        close(pipeFds[1]);
+        int devNull = open("/dev/null", O_RDWR);
+        if (devNull >= 0) {
+            dup2(devNull, STDIN_FILENO);
+            dup2(devNull, STDERR_FILENO);
+        }
+        if (runner.engine.openmp && ompThreads > 0) setenv("OMP_NUM_THREADS", to_string(ompThreads).c_str(), 1);
+        vector<char*> argv;
+        for (const string& arg : args) argv.push_back(const_cast<char*>(arg.c_str()));
+        argv.push_back(nullptr);
+        execv(argv[0], argv.data());
+        _exit(127);
+    }
+    // Also set from the parent, so a kill right after fork still finds the group.
+    setpgid(pid, pid);
+    close(pipeFds[1]);
+    runner.pid = pid;
+    runner.fd = pipeFds[0];
+    return true;
+}
+
+void stopRunner(Runner& runner, bool cancel) {
+    if (runner.pid < 0) return;
+    if (cancel) kill(-runner.pid, SIGKILL);
+    int status = 0;
+    waitpid(runner.pid, &status, 0);
+    runner.pid = -1;
+    if (runner.fd >= 0) close(runner.fd);
+    runner.fd = -1;
+}
+
+/**
+ * @brief Races the engines on the board written to `inputPath`; the first solved/unsolvable record wins
+ */
+RaceResult race(vector<Runner>& runners, const string& inputPath, int side, const vector<string>& passThrough,
+                int ompThreads) {
+    Clock::time_point start = Clock::now();
+    auto elapsed = [&]() { return chrono::duration<double>(Clock::now() - start).count(); };
+    RaceResult result;
+    bool invalid = false;
+
+    int running = 0;
+    for (Runner& runner : runners) {
+        runner.output.clear();
+        runner.outcome.clear();
+        runner.cost = 0;
+        runner.seconds = 0;
+        if (runner.engine.openmp && side != 4) {
+            runner.outcome = "omitido";
+            continue;
+        }
+        vector<string> args = {runner.engine.binary};
+        if (!runner.engine.openmp) args.insert(args.end(), {to_string(side), "--optimal"});
+        args.insert(args.end(), {"--input", inputPath, "--format", "jsonl"});
+        args.insert(args.end(), passThrough.begin(), passThrough.end());
+        if (!startRunner(runner, args, ompThreads)) {
+            runner.outcome = "error";
+            continue;
+        }
+        running++;
+    }
+
+    while (running > 0 && result.engine.empty()) {
+        vector<pollfd> fds;
+        vector<Runner*> owners;
+        for (Runner& runner : runners) {
+            if (runner.fd < 0) continue;
+            fds.push_back({runner.fd, POLLIN, 0});
+            owners.push_back(&runner);
+        }
+        if (poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        for (size_t i = 0; i < fds.size() && result.engine.empty(); i++) {
+            if (!(fds[i].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+            Runner& runner = *owners[i];
+            char buffer[4096];
+            ssize_t n = read(runner.fd, buffer, sizeof(buffer));
+            if (n > 0) {
+                runner.output.append(buffer, (size_t)n);
+                size_t newline;
+                while (runner.outcome.empty() && (newline = runner.output.find('\n')) != string::npos) {
+                    string record = runner.output.substr(0, newline);
+                    runner.output.erase(0, newline + 1);
+                    string status = jsonField(record, "status");
+                    runner.seconds = elapsed();
+                    runner.cost = atoi(jsonField(record, "cost").c_str());
+                    if (status == "solved" || status == "unsolvable") {
+                        runner.outcome = "ganador";
+                        result = {runner.cost, runner.engine.name, runner.seconds};
+                    } else if (status == "invalid") {
+                        runner.outcome = "inválido";
+                        invalid = true;
+                    } else {
+                        runner.outcome = "presupuesto";
+                    }
+                }
+            } else if (n < 0 && errno == EINTR) {
+                continue;
+            } else if (runner.outcome.empty()) {
+                runner.seconds = elapsed();
+                runner.outcome = "error";
+            }
+            if (!runner.outcome.empty()) {
+                stopRunner(runner, runner.outcome != "ganador");
+                running--;
+            }
+        }
+    }
+
+    for (Runner& runner : runners) {
+        if (runner.pid < 0) continue;
+        runner.seconds = elapsed();
+        runner.outcome = "cancelado";
+        stopRunner(runner, true);
+    }
+    if (result.engine.empty()) {
+        result.seconds = elapsed();
+        if (invalid) result.cost = INVALID_BOARD;
+    }
+    return result;
+}
+
+int main(int argc, char* argv[]) {
+    string engineList = "h2,h1,bsp";
+    string binDir = ".";
+    string inputPath = "puzzles.txt";
+    string logPath;
+    int side = 4;
+    int ompThreads = 0;
+    OutputFormat format = FORMAT_TEXT;
+    vector<string> passThrough;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--engines" && hasValue) engineList = argv[++i];
+        else if (arg == "--bin-dir" && hasValue) binDir = argv[++i];
+        else if (arg == "--size" && hasValue) side = atoi(argv[++i]);
+        else if (arg == "--input" && hasValue) inputPath = argv[++i];
+        else if (arg == "--log" && hasValue) logPath = argv[++i];
+        else if (arg == "--omp-threads" && hasValue) ompThreads = max(1, atoi(argv[++i]));
+        else if (arg == "--format" && hasValue && parseOutputFormat(argv[i + 1], format)) i++;
+        else if ((arg == "--time-limit" || arg == "--max-nodes" || arg == "--max-mem") && hasValue) {
+            passThrough.push_back(arg);
+            passThrough.push_back(argv[++i]);
+        } else {
+            cerr << "Uso: " << argv[0] << " [--engines h2,h1,bsp] [--bin-dir <dir>] [--size <n>] [--input <archivo>]"
+                 << " [--format text|jsonl|csv] [--log <archivo.csv>] [--omp-threads <n>]"
+                 << " [--time-limit <s>] [--max-nodes <n>] [--max-mem <MB>]" << endl;
+            return 1;
+        }
+    }
+    if (side < 2) {
+        cerr << "Error: tamaño de tablero no válido" << endl;
+        return 1;
+    }
+
+    vector<Runner> runners;
+    stringstream list(engineList);
+    string item;
+    while (getline(list, item, ',')) {
+        if (item.empty()) continue;
+        string name = item.substr(0, item.find('='));
+        const EngineSpec* known = nullptr;
+        for (const EngineSpec& spec : KNOWN_ENGINES) {
+            if (spec.name == name) known = &spec;
+        }
+        if (!known) {
+            cerr << "Error: motor desconocido '" << name << "' (bsp, h1, h2, bsp_omp, h1_omp, h2_omp)" << endl;
+            return 1;
+        }
+        Runner runner;
+        runner.engine = *known;
+        runner.engine.binary = item.find('=') != string::npos ? item.substr(item.find('=') + 1) : binDir + "/" + known->binary;
+        if (access(runner.engine.binary.c_str(), X_OK) != 0) {
+            cerr << "Error: no se encuentra el ejecutable " << runner.engine.binary << endl;
+            return 1;
+        }
+        runners.push_back(runner);
+    }
+    if (runners.empty()) {
+        cerr << "Error: la cartera no tiene motores" << endl;
+        return 1;
+    }
+
+    BoardSource file(inputPath);
+    if (!file.is_open()) {
+        cerr << "Error: no se pudo abrir " << inputPath << endl;
+        return 1;
+    }
+    if (file.side() != 0) side = file.side();
+
+    ofstream log;
+    if (!logPath.empty()) {
+        bool fresh = !ifstream(logPath).good();
+        log.open(logPath, ios::app);
+        if (!log) {
+            cerr << "Error: no se pudo abrir " << logPath << endl;
+            return 1;
+        }
+        if (fresh) log << "index,board,engine,outcome,cost,seconds" << endl;
+    }
+
+    int tempFd = mkstemp(tempPath);
+    if (tempFd < 0) {
+        cerr << "Error: no se pudo crear un archivo temporal" << endl;
+        return 1;
+    }
+    close(tempFd);
+    activeRunners = &runners;
+    signal(SIGINT, cancelAll);
+    signal(SIGTERM, cancelAll);
+    signal(SIGPIPE, cancelAll);
+
+    if (format == FORMAT_CSV) cout << "index,board,status,cost,engine,seconds" << endl;
+    map<string, int> wins;
+    long long puzzleIndex = 0;
+    string board;
+    while (file.next(board)) {
+        if (board.empty()) continue;
+        puzzleIndex++;
+        ofstream(tempPath) << board << "\n";
+
+        RaceResult result = race(runners, tempPath, side, passThrough, ompThreads);
+        if (!result.engine.empty()) wins[result.engine]++;
+        string engine = result.engine.empty() ? "-" : result.engine;
+
+        if (format == FORMAT_JSONL) {
+            cout << "{\"index\":" << puzzleIndex << ",\"board\":\"" << board << "\",\"status\":\"" << resultStatus(result.cost)
+                 << "\",\"cost\":" << result.cost << ",\"engine\":\"" << engine << "\",\"seconds\":" << result.seconds << "}" << endl;
+        } else if (format == FORMAT_CSV) {
+            cout << puzzleIndex << "," << board << "," << resultStatus(result.cost) << "," << result.cost << "," << engine << ","
+                 << result.seconds << endl;
+        } else {
+            cout << "Procesando tablero: " << board << endl;
+            if (result.cost >= 0) cout << "Resultado: " << result.cost << endl;
+            else if (result.cost == -1) cout << "Resultado: No resuelto" << endl;
+            else if (result.cost == INVALID_BOARD) cout << "Resultado: tablero no válido" << endl;
+            else cout << "Resultado: presupuesto excedido en todos los motores" << endl;
+            cout << "Motor ganador: " << engine << endl;
+            cout << "Tiempo de ejecución: " << result.seconds << " segundos" << endl << endl;
+        }
+        if (log.is_open()) {
+            for (const Runner& runner : runners)
+                log << puzzleIndex << "," << board << "," << runner.engine.name << "," << runner.outcome << ","
+                    << runner.cost << "," << runner.seconds << "\n";
+            log.flush();
+        }
+    }
+    unlink(tempPath);
+
+    if (format == FORMAT_TEXT) {
+        cout << "Victorias por motor:";
+        for (const Runner& runner : runners) cout << " " << runner.engine.name << "=" << wins[runner.engine.name];
+        cout << endl;
+    }
+    return 0;
+}
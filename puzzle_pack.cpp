@@ -0,0 +1,96 @@
+/**
+ * @file puzzle_pack.cpp
+ * @brief Converter between text puzzle files and the binary puzzle-set format
+ *
+ * Compilation:
+ *      g++ -std=c++17 -O2 -o puzzle_pack puzzle_pack.cpp
+ *
+ * Usage:
+ *      ./puzzle_pack pack <entrada.txt> <salida.pzs>   text (one board per line) -> binary
+ *      ./puzzle_pack unpack <entrada.pzs>              binary -> text on stdout
+ *      ./puzzle_pack info <entrada.pzs>                header summary
+ *      ./puzzle_pack get <entrada.pzs> <indice>        one board by index (0-based)
+ *
+ * The board side is taken from the first board of the text file and every
+ * following board must have the same size. Boards are letters ("ABC...#")
+ * or comma-separated tile IDs ("1,2,...,0"), as described in puzzle_tiles.h.
+ */
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cmath>
+#include <algorithm>
+#include "puzzle_set.h"
+
+using namespace std;
+
+int pack(const string& inPath, const string& outPath) {
+    ifstream in(inPath);
+    if (!in) {
+        cerr << "Error: no se pudo abrir " << inPath << endl;
+        return 1;
+    }
+    string board;
+    if (!(in >> board)) {
+        cerr << "Error: " << inPath << " no contiene tableros" << endl;
+        return 1;
+    }
+    size_t cells = board.find(',') == string::npos ? board.size() : count(board.begin(), board.end(), ',') + 1;
+    int side = (int)lround(sqrt((double)cells));
+    if ((size_t)side * side != cells) {
+        cerr << "Error: el número de fichas no es un cuadrado: " << board << endl;
+        return 1;
+    }
+
+    PuzzleSetWriter writer(outPath, side);
+    do {
+        writer.add(board);
+    } while (in >> board);
+    writer.close();
+    cerr << writer.count() << " tableros " << side << "x" << side << " escritos en " << outPath << endl;
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        cerr << "Uso: " << argv[0] << " pack <entrada.txt> <salida.pzs> | unpack <entrada.pzs> | info <entrada.pzs> | get <entrada.pzs> <indice>" << endl;
+        return 1;
+    }
+    string command = argv[1];
+    try {
+        if (command == "pack" && argc == 4) return pack(argv[2], argv[3]);
+
+        PuzzleSet set(argv[2]);
+        if (command == "unpack") {
+            string out;
+            for (PackedBoard board : set) {
+                out += board.text();
+                out += '\n';
+                if (out.size() >= (1 << 16)) {
+                    cout << out;
+                    out.clear();
+                }
+            }
+            cout << out;
+        } else if (command == "info") {
+            cout << "Tableros: " << set.size() << "\n";
+            cout << "Tamaño: " << set.side() << "x" << set.side() << "\n";
+            cout << "Bits por ficha: " << set.bitsPerTile() << "\n";
+        } else if (command == "get" && argc == 4) {
+            size_t index = stoull(argv[3]);
+            if (index >= set.size()) {
+                cerr << "Error: índice fuera de rango (" << set.size() << " tableros)" << endl;
+                return 1;
+            }
+            cout << set[index].text() << "\n";
+        } else {
+            cerr << "Comando desconocido: " << command << endl;
+            return 1;
+        }
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
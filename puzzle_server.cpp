@@ -0,0 +1,472 @@
+/**
+ * @file puzzle_server.cpp
+ * @brief Long-running sliding puzzle solver (A* with Manhattan distance)
+ *
+ * Starts once, keeps the goal tables and a cache of solved boards warm, and
+ * answers boards sent over a line protocol. Boards are solved concurrently by
+ * an internal pool of worker threads and every answer is written back as soon
+ * as it is ready, so answers may arrive in a different order than requests.
+ *
+ * Protocol (one request per line):
+ *   Request:  [<id>] <tablero> [GOAL <objetivo>]
+ *   Response: <id> <tablero> <resultado> <nodos_expandidos> <segundos>
+ * where <resultado> is the solution length, -1 when there is no solution and
+ * -2 when the search exceeded its budget. Every request gets its own budget:
+ * --time-limit, --max-nodes and --max-mem, and DEFAULT_REQUEST_SECONDS when
+ * no time limit is given (--time-limit 0 lifts it), so a hard board only
+ * ties up its worker for that long. When no id is given the line number
+ * of the request within its connection is used. Malformed requests get
+ * "<id> ERROR <mensaje>".
+ *
+ * Next-move queries ask for one good move instead of a full solve:
+ *   Request:  [<id>] NEXT <tablero> [<microsegundos>] [GOAL <objetivo>]
+ *   Response: <id> <tablero> <movimiento> <estimación> <profundidad> <microsegundos>
+ * <movimiento> is UP, DOWN, LEFT or RIGHT (the vocabulary of board_moves and
+ * board_available) or NONE when the board already is the goal. The answer
+ * comes from the bounded lookahead of next_move_oracle.h within the given
+ * budget (--move-budget by default) and is written by the reading thread,
+ * without waiting behind queued solves. The learned estimates are shared by
+ * every connection, so repeated queries along a walk do not loop.
+ *
+ * Either request may end with "GOAL <objetivo>" to solve towards that board
+ * instead of the default goal; the pair is relabeled as in goal_relabel.h,
+ * so goals that reduce to the same layout share tables, cache entries and
+ * learned estimates, and NEXT answers are given on the caller's board.
+ *
+ * Boards are letters ("ABCDEFG#IJKHMNOL") or comma-separated tile IDs, as in
+ * puzzle_tiles.h. The board size is deduced from the number of tiles
+ * (16 -> 4x4, 64 -> 8x8...) and the default goal follows the same layout as
+ * the batch solvers. Boards up to 16x16 are accepted; from MACRO_AUTO_SIDE
+ * up, as in the batch solvers, they are answered by the constructive solver
+ * of macro_solver.h, whose length is valid but not necessarily the shortest.
+ *
+ * Compilation:
+ *      g++ -std=c++17 -O2 -pthread -o puzzle_server puzzle_server.cpp
+ *
+ * Usage:
+ *      ./puzzle_server [--socket <ruta>] [--threads <n>] [--move-budget <µs>] [--time-limit <s>] [--max-nodes <n>] [--max-mem <MB>]
+ *
+ *      # stdin/stdout
+ *      cat puzzles.txt | ./puzzle_server
+ *
+ *      # Unix-domain socket
+ *      ./puzzle_server --socket /tmp/puzzle.sock &
+ *      echo "ABCDEFG#IJKHMNOL" | nc -U /tmp/puzzle.sock
+ */
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <queue>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <unordered_set>
+#include <unordered_map>
+#include <functional>
+#include <algorithm>
+#include <cmath>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "search_budget.h"
+#include "puzzle_tiles.h"
+#include "heuristic_kernels.h"
+#include "macro_solver.h"
+#include "next_move_oracle.h"
+#include "goal_relabel.h"
+
+using namespace std;
+
+const int dRow[] = {-1, 1, 0, 0};
+const int dCol[] = {0, 0, -1, 1};
+const size_t CACHE_LIMIT = 1 << 20;
+const int MAX_SIDE = 16;
+const double DEFAULT_REQUEST_SECONDS = 10;
+
+SearchBudget searchBudget;
+long long moveBudgetMicros = 1000;
+
+/**
+ * @brief Goal board, tile -> goal position table and learned NEXT estimates for one goal layout
+ */
+struct GoalTables {
+    int size;
+    string goal;
+    GoalTable positions;
+    NextMoveOracle oracle;
+};
+
+struct AStarState {
+    string board;
+    int blankPos;
+    int cost;
+    int heuristic;
+
+    AStarState(const string& b, int pos, int c, int h) : board(b), blankPos(pos), cost(c), heuristic(h) {}
+
+    bool operator>(const AStarState& other) const {
+        return (cost + heuristic) > (other.cost + other.heuristic);
+    }
+};
+
+struct SolveResult {
+    int cost;
+    long long expandedNodes;
+    double seconds;
+};
+
+/**
+ * @brief Output side of a client; shared by the reader and the workers
+ *
+ * The descriptor is closed when the last job of the connection is answered.
+ */
+struct Connection {
+    int fd;
+    bool ownsFd;
+    mutex writeMutex;
+
+    Connection(int f, bool owns) : fd(f), ownsFd(owns) {}
+    ~Connection() { if (ownsFd) close(fd); }
+
+    void send(const string& line) {
+        lock_guard<mutex> lock(writeMutex);
+        size_t sent = 0;
+        while (sent < line.size()) {
+            ssize_t n = write(fd, line.data() + sent, line.size() - sent);
+            if (n <= 0) return;
+            sent += n;
+        }
+    }
+};
+
+struct Job {
+    string id;
+    string board;
+    string goal;
+    shared_ptr<Connection> client;
+};
+
+mutex tablesMutex;
+map<pair<int, int>, GoalTables> tablesByLayout;
+
+mutex cacheMutex;
+unordered_map<string, SolveResult> solvedCache;
+
+mutex jobsMutex;
+condition_variable jobsReady;
+queue<Job> jobs;
+bool shuttingDown = false;
+
+/**
+ * @brief Returns the goal tables for a board size and goal blank cell, building them on first use
+ */
+GoalTables& tablesFor(int size, int blankCell) {
+    lock_guard<mutex> lock(tablesMutex);
+    auto it = tablesByLayout.find({size, blankCell});
+    if (it != tablesByLayout.end()) return it->second;
+
+    GoalTables& t = tablesByLayout[{size, blankCell}];
+    vector<uint16_t> goalTiles = canonicalGoalTiles(size, blankCell);
+    t.size = size;
+    t.goal = toBoard<string>(goalTiles);
+    t.positions = GoalTable(goalTiles, size);
+    return t;
+}
+
+int h2_heuristic(const string& board, const GoalTables& t) {
+    return manhattanDistance(board, t.positions);
+}
+
+SolveResult aStarSearch(const string& start, const GoalTables& t) {
+    priority_queue<AStarState, vector<AStarState>, greater<AStarState>> pq;
+    unordered_set<string> visited;
+    BudgetGuard guard(searchBudget, estimatedStateBytes(start.size()));
+    long long expandedNodes = 0;
+
+    pq.push(AStarState(start, blankPosition(start), 0, h2_heuristic(start, t)));
+
+    while (!pq.empty()) {
+        AStarState current = pq.top();
+        pq.pop();
+        // Closed on expansion, so the popped g is the optimal one; later copies are stale.
+        if (visited.count(current.board)) continue;
+        expandedNodes++;
+
+        if (current.board == t.goal) return {current.cost, expandedNodes, guard.elapsed()};
+        if (guard.check(expandedNodes, visited.size() + pq.size())) return {BUDGET_EXCEEDED, expandedNodes, guard.elapsed()};
+        visited.insert(current.board);
+
+        int row = current.blankPos / t.size;
+        int col = current.blankPos % t.size;
+        for (int i = 0; i < 4; i++) {
+            int newRow = row + dRow[i];
+            int newCol = col + dCol[i];
+            if (newRow < 0 || newRow >= t.size || newCol < 0 || newCol >= t.size) continue;
+
+            int newPos = newRow * t.size + newCol;
+            string newBoard = current.board;
+            swap(newBoard[current.blankPos], newBoard[newPos]);
+            if (!visited.count(newBoard)) {
+                pq.push(AStarState(newBoard, newPos, current.cost + 1, h2_heuristic(newBoard, t)));
+            }
+        }
+    }
+    return {-1, expandedNodes, guard.elapsed()};
+}
+
+/**
+ * @brief Constructive answer for boards too large for A*; the length is not necessarily optimal
+ */
+SolveResult macroSearch(const string& start, const GoalTables& t) {
+    auto begin = chrono::steady_clock::now();
+    MacroSolver solver(fromBoard(start), fromBoard(t.goal), t.size);
+    vector<int> moves;
+    int cost = solver.solve(moves);
+    return {cost, solver.residualNodes(), chrono::duration<double>(chrono::steady_clock::now() - begin).count()};
+}
+
+/**
+ * @brief Checks the board shape and converts it to one tile ID per byte
+ */
+string parseBoard(const string& text, int& size, string& board) {
+    size_t cells = text.find(',') == string::npos ? text.size() : count(text.begin(), text.end(), ',') + 1;
+    size = (int)lround(sqrt((double)cells));
+    if (size < 2 || size * size != (int)cells) return "longitud de tablero no cuadrada";
+    if (size > MAX_SIDE) return "tablero mayor que " + to_string(MAX_SIDE) + "x" + to_string(MAX_SIDE);
+    vector<uint16_t> tiles;
+    string error;
+    if (!parseTiles(text, size, tiles, error)) return error;
+    board = toBoard<string>(tiles);
+    return "";
+}
+
+/**
+ * @brief parseBoard plus the optional goal: `board` is left relabeled and `tables` set to its goal layout
+ */
+string parseRequest(const string& text, const string& goalText, string& board, GoalRelabeling& relabeling,
+                    GoalTables*& tables) {
+    int size = 0;
+    string error = parseBoard(text, size, board);
+    if (!error.empty()) return error;
+    int blankCell = size * size - 1;
+    if (!goalText.empty()) {
+        vector<uint16_t> goal;
+        if (!parseTiles(goalText, size, goal, error)) return "objetivo no válido: " + error;
+        relabeling = GoalRelabeling(goal, size);
+        board = toBoard<string>(relabeling.apply(fromBoard(board)));
+        blankCell = relabeling.blankCell();
+    }
+    tables = &tablesFor(size, blankCell);
+    return "";
+}
+
+void solveJob(const Job& job) {
+    ostringstream out;
+    string board;
+    GoalRelabeling relabeling;
+    GoalTables* tables = nullptr;
+    string error = parseRequest(job.board, job.goal, board, relabeling, tables);
+    if (!error.empty()) {
+        out << job.id << " ERROR " << error << "\n";
+        job.client->send(out.str());
+        return;
+    }
+
+    // Keyed by the relabeled board and its goal layout, so equivalent (board, goal) pairs share an entry.
+    string key = to_string(blankPosition(tables->goal)) + " " + board;
+    SolveResult result;
+    bool cached = false;
+    {
+        lock_guard<mutex> lock(cacheMutex);
+        auto it = solvedCache.find(key);
+        if (it != solvedCache.end()) {
+            result = it->second;
+            result.seconds = 0;
+            cached = true;
+        }
+    }
+    if (!cached) {
+        // A* would expand half the state space before giving up on an unsolvable board.
+        if (!isSolvable(fromBoard(board), fromBoard(tables->goal), tables->size)) result = {-1, 0, 0};
+        else if (tables->size >= MACRO_AUTO_SIDE) result = macroSearch(board, *tables);
+        else result = aStarSearch(board, *tables);
+        if (result.cost != BUDGET_EXCEEDED) {
+            lock_guard<mutex> lock(cacheMutex);
+            if (solvedCache.size() >= CACHE_LIMIT) solvedCache.clear();
+            solvedCache[key] = result;
+        }
+    }
+
+    out << job.id << " " << job.board << " " << result.cost << " "
+        << result.expandedNodes << " " << result.seconds << "\n";
+    job.client->send(out.str());
+}
+
+/**
+ * @brief Answers a NEXT query on the calling thread
+ */
+void answerNextMove(const string& id, const string& text, const string& goalText, long long budgetMicros,
+                    Connection& client) {
+    auto start = chrono::steady_clock::now();
+    ostringstream out;
+    string board;
+    GoalRelabeling relabeling;
+    GoalTables* tables = nullptr;
+    string error = parseRequest(text, goalText, board, relabeling, tables);
+    if (error.empty() && !isSolvable(fromBoard(board), fromBoard(tables->goal), tables->size))
+        error = "tablero sin solución";
+    if (!error.empty()) {
+        out << id << " ERROR " << error << "\n";
+        client.send(out.str());
+        return;
+    }
+
+    NextMoveOracle::Answer answer = tables->oracle.next(board, tables->positions, budgetMicros);
+    long long micros = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count();
+    out << id << " " << text << " " << (answer.move < 0 ? "NONE" : moveName(relabeling.userMove(answer.move))) << " "
+        << answer.estimate << " " << answer.depth << " " << micros << "\n";
+    client.send(out.str());
+}
+
+void workerLoop() {
+    while (true) {
+        Job job;
+        {
+            unique_lock<mutex> lock(jobsMutex);
+            jobsReady.wait(lock, [] { return shuttingDown || !jobs.empty(); });
+            if (jobs.empty()) return;
+            job = move(jobs.front());
+            jobs.pop();
+        }
+        solveJob(job);
+    }
+}
+
+void submit(Job job) {
+    {
+        lock_guard<mutex> lock(jobsMutex);
+        jobs.push(move(job));
+    }
+    jobsReady.notify_one();
+}
+
+/**
+ * @brief Reads requests from a descriptor until EOF and queues them
+ */
+void readRequests(int inFd, shared_ptr<Connection> client) {
+    string pending;
+    char buffer[4096];
+    long long lineNumber = 0;
+
+    auto handleLine = [&](const string& text) {
+        lineNumber++;
+        istringstream line(text);
+        vector<string> fields;
+        string field;
+        while (line >> field) fields.push_back(field);
+        string goal;
+        if (fields.size() >= 2 && fields[fields.size() - 2] == "GOAL") {
+            goal = fields.back();
+            fields.resize(fields.size() - 2);
+        }
+        if (fields.empty()) return;
+
+        size_t next = find(fields.begin(), fields.end(), "NEXT") - fields.begin();
+        if (next <= 1 && next + 1 < fields.size()) {
+            string id = next == 1 ? fields[0] : to_string(lineNumber);
+            long long budget = moveBudgetMicros;
+            if (next + 2 < fields.size()) budget = max(1LL, atoll(fields[next + 2].c_str()));
+            answerNextMove(id, fields[next + 1], goal, budget, *client);
+            return;
+        }
+
+        Job job;
+        job.client = client;
+        job.id = fields.size() > 1 ? fields[0] : to_string(lineNumber);
+        job.board = fields.back();
+        job.goal = goal;
+        submit(move(job));
+    };
+
+    while (true) {
+        ssize_t n = read(inFd, buffer, sizeof(buffer));
+        if (n <= 0) break;
+        pending.append(buffer, n);
+
+        size_t startLine = 0, endLine;
+        while ((endLine = pending.find('\n', startLine)) != string::npos) {
+            handleLine(pending.substr(startLine, endLine - startLine));
+            startLine = endLine + 1;
+        }
+        pending.erase(0, startLine);
+    }
+    if (!pending.empty()) handleLine(pending);
+}
+
+int serveSocket(const string& path) {
+    int listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0) {
+        cerr << "Error: no se pudo crear el socket" << endl;
+        return 1;
+    }
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        cerr << "Error: ruta de socket demasiado larga" << endl;
+        return 1;
+    }
+    strcpy(addr.sun_path, path.c_str());
+    unlink(path.c_str());
+    if (bind(listenFd, (sockaddr*)&addr, sizeof(addr)) < 0 || listen(listenFd, 64) < 0) {
+        cerr << "Error: no se pudo escuchar en " << path << endl;
+        return 1;
+    }
+    cerr << "Escuchando en " << path << endl;
+
+    while (true) {
+        int clientFd = accept(listenFd, nullptr, nullptr);
+        if (clientFd < 0) continue;
+        auto client = make_shared<Connection>(clientFd, true);
+        thread(readRequests, clientFd, client).detach();
+    }
+}
+
+int main(int argc, char* argv[]) {
+    string socketPath;
+    int threads = max(1u, thread::hardware_concurrency());
+    searchBudget.seconds = DEFAULT_REQUEST_SECONDS;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--socket" && i + 1 < argc) socketPath = argv[++i];
+        else if (arg == "--threads" && i + 1 < argc) threads = max(1, stoi(argv[++i]));
+        else if (arg == "--move-budget" && i + 1 < argc) moveBudgetMicros = max(1LL, stoll(argv[++i]));
+        else if (!parseBudgetOption(i, argc, argv, searchBudget)) {
+            cerr << "Uso: " << argv[0] << " [--socket <ruta>] [--threads <n>] [--move-budget <µs>] [--time-limit <s>] [--max-nodes <n>] [--max-mem <MB>]" << endl;
+            return 1;
+        }
+    }
+    signal(SIGPIPE, SIG_IGN);
+
+    tablesFor(4, 15);
+    vector<thread> pool;
+    for (int i = 0; i < threads; i++) pool.emplace_back(workerLoop);
+
+    if (!socketPath.empty()) return serveSocket(socketPath);
+
+    readRequests(STDIN_FILENO, make_shared<Connection>(STDOUT_FILENO, false));
+    {
+        lock_guard<mutex> lock(jobsMutex);
+        shuttingDown = true;
+    }
+    jobsReady.notify_all();
+    for (auto& worker : pool) worker.join();
+    return 0;
+}
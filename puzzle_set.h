@@ -0,0 +1,297 @@
+/**
+ * @file puzzle_set.h
+ * @brief Compact binary puzzle-set format with memory-mapped loading
+ *
+ * Layout (little endian):
+ *   offset  0  char[4]  magic "PZST"
+ *   offset  4  uint16   format version (1)
+ *   offset  6  uint16   board side (4 for 4x4)
+ *   offset  8  uint8    bits per tile (4, 8 or 16)
+ *   offset  9  uint8[7] reserved, zero
+ *   offset 16  uint64   number of boards
+ *   offset 24  uint64   reserved, zero
+ *   offset 32  records, one per board, each ceil(side*side*bits/8) bytes
+ *
+ * Tiles are stored row-major as their tile IDs (see puzzle_tiles.h: 0 is the
+ * blank, letter 'A' + k is k + 1). With 4 bits per tile a 4x4 board is 8
+ * bytes, two tiles per byte with the first tile in the low nibble. Records have a fixed
+ * size, so board i is at 32 + i * recordBytes and is read straight from the
+ * mapping without parsing or copying the file.
+ */
+#ifndef PUZZLE_SET_H
+#define PUZZLE_SET_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "puzzle_tiles.h"
+
+const char PUZZLE_SET_MAGIC[4] = {'P', 'Z', 'S', 'T'};
+const uint16_t PUZZLE_SET_VERSION = 1;
+const size_t PUZZLE_SET_HEADER_BYTES = 32;
+
+/**
+ * @brief Smallest supported tile width able to hold every ID of a side x side board
+ */
+inline int bitsPerTileFor(int side) {
+    int maxId = side * side - 1;
+    if (maxId < 16) return 4;
+    if (maxId < 256) return 8;
+    return 16;
+}
+
+/**
+ * @brief Non-owning view of one packed record inside a mapping
+ */
+struct PackedBoard {
+    const uint8_t* data;
+    int side;
+    int bits;
+
+    int tile(int cell) const {
+        if (bits == 4) return (data[cell >> 1] >> ((cell & 1) * 4)) & 0xF;
+        if (bits == 8) return data[cell];
+        return data[2 * cell] | (data[2 * cell + 1] << 8);
+    }
+
+    std::vector<uint16_t> tiles() const {
+        std::vector<uint16_t> result(side * side);
+        for (int i = 0; i < side * side; i++) result[i] = (uint16_t)tile(i);
+        return result;
+    }
+
+    std::string text() const { return formatTiles(tiles(), side); }
+};
+
+/**
+ * @brief Read-only, memory-mapped puzzle set
+ */
+class PuzzleSet {
+public:
+    explicit PuzzleSet(const std::string& path) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw std::runtime_error("no se pudo abrir " + path);
+        struct stat st;
+        if (fstat(fd, &st) < 0 || (size_t)st.st_size < PUZZLE_SET_HEADER_BYTES) {
+            close(fd);
+            throw std::runtime_error(path + " no es un conjunto de tableros válido");
+        }
+        bytes_ = st.st_size;
+        void* map = mmap(nullptr, bytes_, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (map == MAP_FAILED) throw std::runtime_error("no se pudo mapear " + path);
+        base_ = (const uint8_t*)map;
+        madvise(map, bytes_, MADV_SEQUENTIAL);
+
+        uint16_t version, side;
+        memcpy(&version, base_ + 4, 2);
+        memcpy(&side, base_ + 6, 2);
+        memcpy(&count_, base_ + 16, 8);
+        side_ = side;
+        bits_ = base_[8];
+        recordBytes_ = ((size_t)side_ * side_ * bits_ + 7) / 8;
+        if (memcmp(base_, PUZZLE_SET_MAGIC, 4) != 0 || version != PUZZLE_SET_VERSION ||
+            (bits_ != 4 && bits_ != 8 && bits_ != 16) || side_ < 2 ||
+            count_ > (bytes_ - PUZZLE_SET_HEADER_BYTES) / recordBytes_) {
+            munmap(map, bytes_);
+            throw std::runtime_error(path + " no es un conjunto de tableros válido");
+        }
+    }
+
+    ~PuzzleSet() { munmap((void*)base_, bytes_); }
+
+    PuzzleSet(const PuzzleSet&) = delete;
+    PuzzleSet& operator=(const PuzzleSet&) = delete;
+
+    size_t size() const { return count_; }
+    int side() const { return side_; }
+    int bitsPerTile() const { return bits_; }
+
+    PackedBoard operator[](size_t i) const {
+        return {base_ + PUZZLE_SET_HEADER_BYTES + i * recordBytes_, side_, bits_};
+    }
+
+    struct iterator {
+        const PuzzleSet* set;
+        size_t i;
+        PackedBoard operator*() const { return (*set)[i]; }
+        iterator& operator++() { ++i; return *this; }
+        bool operator!=(const iterator& other) const { return i != other.i; }
+    };
+
+    iterator begin() const { return {this, 0}; }
+    iterator end() const { return {this, count_}; }
+
+private:
+    const uint8_t* base_ = nullptr;
+    size_t bytes_ = 0;
+    uint64_t count_ = 0;
+    int side_ = 0;
+    int bits_ = 0;
+    size_t recordBytes_ = 0;
+};
+
+/**
+ * @brief Appends packed boards to a new puzzle-set file
+ *
+ * The board count in the header is patched when the writer is closed.
+ */
+class PuzzleSetWriter {
+public:
+    PuzzleSetWriter(const std::string& path, int side)
+        : out_(path, std::ios::binary), side_(side), bits_(bitsPerTileFor(side)),
+          record_(((size_t)side * side * bits_ + 7) / 8, 0) {
+        if (!out_) throw std::runtime_error("no se pudo crear " + path);
+        uint8_t header[PUZZLE_SET_HEADER_BYTES] = {0};
+        uint16_t version = PUZZLE_SET_VERSION, side16 = side;
+        memcpy(header, PUZZLE_SET_MAGIC, 4);
+        memcpy(header + 4, &version, 2);
+        memcpy(header + 6, &side16, 2);
+        header[8] = (uint8_t)bits_;
+        out_.write((const char*)header, sizeof(header));
+    }
+
+    ~PuzzleSetWriter() { close(); }
+
+    void add(const std::string& board) {
+        std::vector<uint16_t> tiles;
+        std::string error;
+        if (!parseTiles(board, side_, tiles, error)) throw std::runtime_error(board + ": " + error);
+        std::fill(record_.begin(), record_.end(), 0);
+        for (int i = 0; i < side_ * side_; i++) {
+            int code = tiles[i];
+            if (bits_ == 4) record_[i >> 1] |= code << ((i & 1) * 4);
+            else if (bits_ == 8) record_[i] = code;
+            else {
+                record_[2 * i] = code & 0xFF;
+                record_[2 * i + 1] = code >> 8;
+            }
+        }
+        out_.write(record_.data(), record_.size());
+        count_++;
+    }
+
+    void close() {
+        if (!out_.is_open()) return;
+        out_.seekp(16);
+        out_.write((const char*)&count_, 8);
+        out_.close();
+    }
+
+    uint64_t count() const { return count_; }
+
+private:
+    std::ofstream out_;
+    int side_;
+    int bits_;
+    std::string record_;
+    uint64_t count_ = 0;
+};
+
+/**
+ * @brief Returns true when the file starts with the puzzle-set magic
+ */
+inline bool isPuzzleSetFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    char magic[4] = {0};
+    in.read(magic, 4);
+    return in && memcmp(magic, PUZZLE_SET_MAGIC, 4) == 0;
+}
+
+/**
+ * @brief One board handed out by BoardSource
+ *
+ * A record of a binary set arrives as its tile IDs, so the solvers that work
+ * on tile IDs skip parsing it, and is only formatted when an output record
+ * needs its text. A line of a text file is kept as read.
+ */
+struct SourceBoard {
+    std::string line;             // text input; empty for binary sets
+    std::vector<uint16_t> tiles;  // binary sets; empty for text input
+    int side = 0;
+
+    SourceBoard() = default;
+    explicit SourceBoard(const std::string& text) : line(text) {}
+
+    bool empty() const { return line.empty() && tiles.empty(); }
+
+    std::string text() const { return tiles.empty() ? line : formatTiles(tiles, side); }
+
+    /**
+     * @brief Tile IDs of the board, parsing text input as parseTiles does
+     */
+    bool parse(int boardSide, std::vector<uint16_t>& out, std::string& error) const {
+        if (tiles.empty()) return parseTiles(line, boardSide, out, error);
+        out = tiles;
+        return true;
+    }
+};
+
+/**
+ * @brief Sequential board reader over either a text file or a binary puzzle set
+ *
+ * Lets the batch solvers keep their `while (source.next(board))` loop for
+ * both formats.
+ */
+class BoardSource {
+public:
+    explicit BoardSource(const std::string& path) {
+        if (!isPuzzleSetFile(path)) {
+            text_.open(path);
+            return;
+        }
+        try {
+            set_ = new PuzzleSet(path);
+        } catch (const std::runtime_error&) {
+            set_ = nullptr;
+        }
+    }
+
+    ~BoardSource() { delete set_; }
+
+    bool is_open() const { return set_ != nullptr || text_.is_open(); }
+
+    /**
+     * @brief Board side of a binary set, 0 for text input
+     */
+    int side() const { return set_ ? set_->side() : 0; }
+
+    bool next(std::string& board) {
+        if (set_) {
+            if (index_ >= set_->size()) return false;
+            board = (*set_)[index_++].text();
+            return true;
+        }
+        return (bool)(text_ >> board);
+    }
+
+    /**
+     * @brief Like next(std::string&), but boards of a binary set are handed out as tile IDs
+     */
+    bool next(SourceBoard& board) {
+        if (set_) {
+            if (index_ >= set_->size()) return false;
+            board.line.clear();
+            board.tiles = (*set_)[index_++].tiles();
+            board.side = set_->side();
+            return true;
+        }
+        board.tiles.clear();
+        return (bool)(text_ >> board.line);
+    }
+
+private:
+    PuzzleSet* set_ = nullptr;
+    std::ifstream text_;
+    size_t index_ = 0;
+};
+
+#endif
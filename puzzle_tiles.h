@@ -0,0 +1,170 @@
+/**
+ * @file puzzle_tiles.h
+ * @brief Unique integer tile IDs for boards of any size
+ *
+ * Tiles are numbered 1..N-1 (N = side * side) and the blank is 0. The goal
+ * places tile k in cell k - 1 and the blank in the last cell, which is the
+ * layout of the 4x4 letter goal "ABCDEFGHIJKLMNO#". Every tile has a single
+ * goal cell, so the tile -> goal position table is computed once per size.
+ *
+ * Boards whose IDs fit in a byte (up to 16x16) are stored one byte per cell
+ * in a std::string; bigger boards use one uint16 per cell in a
+ * std::u16string. Both are hashable by std::hash, so the solvers keep their
+ * unordered_set / unordered_map closed lists.
+ *
+ * Text forms accepted and produced:
+ *   letters  "ABCDEFG#IJKHMNOL"  when every tile fits in A-Z (N - 1 <= 26)
+ *   numbers  "1,2,3,...,63,0"    any size; '#' is also accepted for the blank
+ */
+#ifndef PUZZLE_TILES_H
+#define PUZZLE_TILES_H
+
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+const int BLANK_TILE = 0;
+
+inline bool usesWideTiles(int side) { return side * side - 1 > 255; }
+
+inline bool usesLetterTiles(int side) { return side * side - 1 <= 26; }
+
+/**
+ * @brief Tile ID stored in a board cell (char cells are read as unsigned)
+ */
+template <class Cell>
+inline int tileAt(Cell cell) {
+    return (int)(typename std::make_unsigned<Cell>::type)cell;
+}
+
+/**
+ * @brief Parses `cells` tiles in either text form and checks they are a permutation
+ *
+ * Used directly for non-square boards (the distance-table builder's 2x3 and
+ * 2x4); square boards go through parseTiles.
+ */
+inline bool parseTileList(const std::string& text, int cells, std::vector<uint16_t>& tiles, std::string& error) {
+    tiles.clear();
+    if (text.find(',') == std::string::npos && (int)text.size() == cells) {
+        for (char c : text) {
+            if (c == '#') tiles.push_back(BLANK_TILE);
+            else if (c >= 'A' && c <= 'Z') tiles.push_back(c - 'A' + 1);
+            else {
+                error = std::string("carácter no válido '") + c + "'";
+                return false;
+            }
+        }
+    } else {
+        size_t pos = 0;
+        while (pos <= text.size()) {
+            size_t comma = text.find(',', pos);
+            if (comma == std::string::npos) comma = text.size();
+            std::string field = text.substr(pos, comma - pos);
+            if (field == "#") tiles.push_back(BLANK_TILE);
+            else if (!field.empty() && field.find_first_not_of("0123456789") == std::string::npos && field.size() < 6)
+                tiles.push_back((uint16_t)std::stoi(field));
+            else {
+                error = "ficha no válida '" + field + "'";
+                return false;
+            }
+            pos = comma + 1;
+        }
+    }
+    if ((int)tiles.size() != cells) {
+        error = "se esperaban " + std::to_string(cells) + " fichas y hay " + std::to_string(tiles.size());
+        return false;
+    }
+    std::vector<bool> seen(cells, false);
+    for (uint16_t t : tiles) {
+        if (t >= cells || seen[t]) {
+            error = "las fichas deben ser 0.." + std::to_string(cells - 1) + " sin repetir";
+            return false;
+        }
+        seen[t] = true;
+    }
+    return true;
+}
+
+/**
+ * @brief Parses a text board into tile IDs and checks it is a permutation
+ */
+inline bool parseTiles(const std::string& text, int side, std::vector<uint16_t>& tiles, std::string& error) {
+    return parseTileList(text, side * side, tiles, error);
+}
+
+/**
+ * @brief Text form of a board: letters when they are enough, numbers otherwise
+ */
+inline std::string formatTiles(const std::vector<uint16_t>& tiles, int side) {
+    std::string text;
+    if (usesLetterTiles(side)) {
+        for (uint16_t t : tiles) text += t == BLANK_TILE ? '#' : (char)('A' + t - 1);
+        return text;
+    }
+    for (size_t i = 0; i < tiles.size(); i++) {
+        if (i > 0) text += ',';
+        text += std::to_string(tiles[i]);
+    }
+    return text;
+}
+
+template <class Board>
+inline Board toBoard(const std::vector<uint16_t>& tiles) {
+    Board board(tiles.size(), 0);
+    for (size_t i = 0; i < tiles.size(); i++) board[i] = (typename Board::value_type)tiles[i];
+    return board;
+}
+
+template <class Board>
+inline std::vector<uint16_t> fromBoard(const Board& board) {
+    std::vector<uint16_t> tiles(board.size());
+    for (size_t i = 0; i < board.size(); i++) tiles[i] = (uint16_t)tileAt(board[i]);
+    return tiles;
+}
+
+template <class Board>
+inline int blankPosition(const Board& board) {
+    for (size_t i = 0; i < board.size(); i++) {
+        if (tileAt(board[i]) == BLANK_TILE) return (int)i;
+    }
+    return -1;
+}
+
+inline std::vector<uint16_t> canonicalGoalTiles(int side) {
+    std::vector<uint16_t> goal(side * side);
+    for (int i = 0; i < side * side - 1; i++) goal[i] = i + 1;
+    goal[side * side - 1] = BLANK_TILE;
+    return goal;
+}
+
+/**
+ * @brief Goal row and column of every tile, indexed by tile ID
+ *
+ * cellRow / cellCol hold the row and column of every cell, so the Manhattan
+ * kernels can load them instead of dividing by the side.
+ */
+struct GoalTable {
+    int side = 0;
+    std::vector<int> position;
+    std::vector<int> row;
+    std::vector<int> col;
+    std::vector<int> cellRow;
+    std::vector<int> cellCol;
+
+    GoalTable() = default;
+    GoalTable(const std::vector<uint16_t>& goal, int boardSide) : side(boardSide) {
+        position.assign(goal.size(), -1);
+        row.assign(goal.size(), 0);
+        col.assign(goal.size(), 0);
+        cellRow.assign(goal.size(), 0);
+        cellCol.assign(goal.size(), 0);
+        for (size_t i = 0; i < goal.size(); i++) {
+            position[goal[i]] = (int)i;
+            row[goal[i]] = cellRow[i] = (int)i / side;
+            col[goal[i]] = cellCol[i] = (int)i % side;
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,132 @@
+/**
+ * @file result_writer.h
+ * @brief Buffered, machine-readable result records for the batch solvers
+ *
+ * Each solved board becomes one record tagged with its puzzle index (its
+ * position in the input, starting at 1), so records can be written in the
+ * order workers finish and still be matched to their input. Records are
+ * accumulated in memory and written in large blocks instead of flushing
+ * after every line.
+ *
+ * Formats:
+ *   jsonl  {"index":3,"board":"...","status":"solved","cost":22,"expanded":1168,"stored":2300,"seconds":0.0011}
+ *   csv    index,board,status,cost,expanded,stored,seconds
+ *   text   the human-readable Spanish block printed by the solvers
+ *
+ * status is "solved", "unsolvable" (cost -1), "budget_exceeded" (cost -2) or
+ * "invalid" (cost -3, the board could not be parsed). Only the first two
+ * are answers about the board.
+ */
+#ifndef RESULT_WRITER_H
+#define RESULT_WRITER_H
+
+#include <cstdio>
+#include <mutex>
+#include <sstream>
+#include <string>
+
+enum OutputFormat { FORMAT_TEXT, FORMAT_JSONL, FORMAT_CSV };
+
+/**
+ * @brief Counters a search reports besides its result
+ */
+struct SearchStats {
+    long long expandedNodes = 0;
+    size_t storedStates = 0;
+};
+
+struct ResultRecord {
+    long long index;
+    std::string board;
+    int cost;
+    SearchStats stats;
+    double seconds;
+};
+
+/**
+ * @brief Result of a board that could not be parsed; never an answer about the board
+ */
+const int INVALID_BOARD = -3;
+
+inline bool parseOutputFormat(const std::string& name, OutputFormat& format) {
+    if (name == "text") format = FORMAT_TEXT;
+    else if (name == "jsonl") format = FORMAT_JSONL;
+    else if (name == "csv") format = FORMAT_CSV;
+    else return false;
+    return true;
+}
+
+inline const char* resultStatus(int cost) {
+    if (cost >= 0) return "solved";
+    if (cost == -2) return "budget_exceeded";
+    if (cost == INVALID_BOARD) return "invalid";
+    return "unsolvable";
+}
+
+class ResultWriter {
+public:
+    static const size_t FLUSH_BYTES = 1 << 16;
+
+    ResultWriter(FILE* out, OutputFormat format) : out_(out), format_(format) {
+        if (format_ == FORMAT_CSV) buffer_ = "index,board,status,cost,expanded,stored,seconds\n";
+    }
+
+    ~ResultWriter() { flush(); }
+
+    /**
+     * @brief Appends one record; safe to call from several threads
+     */
+    void write(const ResultRecord& r) {
+        std::ostringstream line;
+        if (format_ == FORMAT_JSONL) {
+            line << "{\"index\":" << r.index << ",\"board\":\"" << escaped(r.board)
+                 << "\",\"status\":\"" << resultStatus(r.cost) << "\",\"cost\":" << r.cost
+                 << ",\"expanded\":" << r.stats.expandedNodes << ",\"stored\":" << r.stats.storedStates
+                 << ",\"seconds\":" << r.seconds << "}\n";
+        } else if (format_ == FORMAT_CSV) {
+            line << r.index << "," << r.board << "," << resultStatus(r.cost) << "," << r.cost << ","
+                 << r.stats.expandedNodes << "," << r.stats.storedStates << "," << r.seconds << "\n";
+        } else {
+            line << "Procesando tablero: " << r.board << "\n";
+            line << "Nodos expandidos: " << r.stats.expandedNodes << "\n";
+            if (r.cost >= 0) line << "Resultado: " << r.cost << "\n";
+            else if (r.cost == -2) line << "Resultado: presupuesto excedido\n";
+            else if (r.cost == INVALID_BOARD) line << "Resultado: tablero no válido\n";
+            else line << "Resultado: No resuelto\n";
+            line << "Tiempo de ejecución: " << r.seconds << " segundos\n\n";
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        buffer_ += line.str();
+        if (buffer_.size() >= FLUSH_BYTES) flushLocked();
+    }
+
+    void flush() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        flushLocked();
+    }
+
+private:
+    static std::string escaped(const std::string& text) {
+        std::string out;
+        for (char c : text) {
+            if (c == '"' || c == '\\') out += '\\';
+            out += c;
+        }
+        return out;
+    }
+
+    void flushLocked() {
+        if (buffer_.empty()) return;
+        fwrite(buffer_.data(), 1, buffer_.size(), out_);
+        fflush(out_);
+        buffer_.clear();
+    }
+
+    FILE* out_;
+    OutputFormat format_;
+    std::string buffer_;
+    std::mutex mutex_;
+};
+
+#endif
@@ -0,0 +1,133 @@
+/**
+ * @file search_budget.h
+ * @brief Per-search time, node and memory limits
+ *
+ * Every solver builds a BudgetGuard at the start of a search and polls it
+ * from its expansion loop. The guard is cheap to poll: node and memory caps
+ * are plain comparisons and the clock is only read every CLOCK_STRIDE calls.
+ * Once a limit is hit the guard stays tripped, so OpenMP threads can poll
+ * tripped() next to the existing `found` flag and leave the region early.
+ *
+ * A search that stops on its budget returns BUDGET_EXCEEDED (-2), which is
+ * distinct from -1 (state space exhausted without reaching the goal).
+ */
+#ifndef SEARCH_BUDGET_H
+#define SEARCH_BUDGET_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+const int BUDGET_EXCEEDED = -2;
+
+/**
+ * @brief Limits for a single search; 0 disables the corresponding limit
+ */
+struct SearchBudget {
+    double seconds = 0;
+    long long maxNodes = 0;
+    size_t maxMemoryMB = 0;
+};
+
+enum BudgetReason { BUDGET_OK = 0, BUDGET_TIME, BUDGET_NODES, BUDGET_MEMORY };
+
+/**
+ * @brief Approximate bytes held per stored state (closed-set entry plus open-list copy)
+ *
+ * Counts the std::string object, its heap buffer once the board no longer
+ * fits in the small-string buffer, and the hash node and bucket overhead.
+ */
+inline size_t estimatedStateBytes(size_t boardLength) {
+    size_t heap = boardLength > 15 ? ((boardLength + 16) & ~size_t(15)) : 0;
+    return 2 * (sizeof(std::string) + heap) + 3 * sizeof(void*) + 16;
+}
+
+class BudgetGuard {
+public:
+    static const unsigned CLOCK_STRIDE = 1024;
+
+    BudgetGuard(const SearchBudget& budget, size_t bytesPerState)
+        : budget_(budget), bytesPerState_(bytesPerState),
+          start_(std::chrono::steady_clock::now()) {
+        deadline_ = start_ + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                 std::chrono::duration<double>(budget.seconds));
+    }
+
+    /**
+     * @brief Sequential poll, called once per expanded node
+     */
+    bool check(long long expanded, size_t storedStates) {
+        if (tripped()) return true;
+        if (overLimits(expanded, storedStates)) return true;
+        if (++calls_ % CLOCK_STRIDE == 0) return timeUp();
+        return false;
+    }
+
+    /**
+     * @brief Node and memory caps; safe to call from several threads
+     */
+    bool overLimits(long long expanded, size_t storedStates) {
+        if (budget_.maxNodes > 0 && expanded >= budget_.maxNodes) return trip(BUDGET_NODES);
+        if (budget_.maxMemoryMB > 0 &&
+            storedStates * bytesPerState_ >= budget_.maxMemoryMB * 1024 * 1024) return trip(BUDGET_MEMORY);
+        return false;
+    }
+
+    /**
+     * @brief Reads the clock; safe to call from several threads
+     */
+    bool timeUp() {
+        if (budget_.seconds > 0 && std::chrono::steady_clock::now() >= deadline_) return trip(BUDGET_TIME);
+        return tripped();
+    }
+
+    bool tripped() const { return reason_.load(std::memory_order_relaxed) != BUDGET_OK; }
+
+    BudgetReason reason() const { return (BudgetReason)reason_.load(); }
+
+    const char* reasonText() const {
+        switch (reason()) {
+            case BUDGET_TIME: return "tiempo";
+            case BUDGET_NODES: return "nodos";
+            case BUDGET_MEMORY: return "memoria";
+            default: return "ninguno";
+        }
+    }
+
+    double elapsed() const {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+    }
+
+private:
+    bool trip(BudgetReason why) {
+        int expected = BUDGET_OK;
+        reason_.compare_exchange_strong(expected, why);
+        return true;
+    }
+
+    SearchBudget budget_;
+    size_t bytesPerState_;
+    std::chrono::steady_clock::time_point start_;
+    std::chrono::steady_clock::time_point deadline_;
+    std::atomic<int> reason_{BUDGET_OK};
+    unsigned calls_ = 0;
+};
+
+/**
+ * @brief Consumes a budget flag from the command line
+ *
+ * Recognises --time-limit <s>, --max-nodes <n> and --max-mem <MB>. Returns
+ * false when argv[i] is not a budget flag so the caller can try its own.
+ */
+inline bool parseBudgetOption(int& i, int argc, char* argv[], SearchBudget& budget) {
+    std::string arg = argv[i];
+    if (i + 1 >= argc) return false;
+    if (arg == "--time-limit") budget.seconds = std::stod(argv[++i]);
+    else if (arg == "--max-nodes") budget.maxNodes = std::stoll(argv[++i]);
+    else if (arg == "--max-mem") budget.maxMemoryMB = std::stoull(argv[++i]);
+    else return false;
+    return true;
+}
+
+#endif
@@ -0,0 +1,306 @@
+/**
+ * @file search_checkpoint.h
+ * @brief On-disk snapshots of a running search, and resuming from them
+ *
+ * With --checkpoint <dir> an engine writes its open list, closed list and
+ * counters to <dir>/<engine>-<hash>.pzck every --checkpoint-every seconds
+ * (300 by default), when it stops on its budget, and when the process gets
+ * SIGTERM or SIGINT. The hash covers the engine, its parameters and the
+ * start board, so a rerun of the same command on the same board finds the
+ * snapshot, loads it and continues from there; the file is removed once the
+ * search finishes. Snapshots are only taken between expansions, where the
+ * open and closed lists agree, and hold no per-thread state, so an OpenMP
+ * engine can resume with any thread count.
+ *
+ * A snapshot is written to <file>.tmp and renamed over the previous one,
+ * so a process killed mid-write leaves the last complete snapshot behind.
+ *
+ * Layout (native byte order):
+ *   offset 0  char[4]  magic "PZCK"
+ *   offset 4  uint16   format version (2)
+ *   offset 6  uint16   reserved, zero
+ *   offset 8  uint32   identity length, then the identity bytes
+ *   then      engine body: counters, open list, closed list
+ */
+#ifndef SEARCH_CHECKPOINT_H
+#define SEARCH_CHECKPOINT_H
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <sys/stat.h>
+
+const char CHECKPOINT_MAGIC[4] = {'P', 'Z', 'C', 'K'};
+const uint16_t CHECKPOINT_VERSION = 2;
+
+/**
+ * @brief Where and how often to write snapshots; an empty directory disables them
+ */
+struct CheckpointOptions {
+    std::string directory;
+    double seconds = 300;
+};
+
+/**
+ * @brief Parses --checkpoint <dir> and --checkpoint-every <s>; false if argv[i] is neither
+ */
+inline bool parseCheckpointOption(int& i, int argc, char* argv[], CheckpointOptions& options) {
+    std::string arg = argv[i];
+    if (i + 1 >= argc) return false;
+    if (arg == "--checkpoint") options.directory = argv[++i];
+    else if (arg == "--checkpoint-every") options.seconds = std::stod(argv[++i]);
+    else return false;
+    return true;
+}
+
+inline std::atomic<bool> checkpointStop(false);
+
+/**
+ * @brief First SIGTERM/SIGINT asks the searches to snapshot and stop; a second one kills
+ */
+inline void onCheckpointSignal(int signal) {
+    checkpointStop.store(true);
+    std::signal(signal, SIG_DFL);
+}
+
+/**
+ * @brief True once a signal asked the process to stop; batch loops then start and report no more boards
+ */
+inline bool checkpointStopRequested() { return checkpointStop.load(std::memory_order_relaxed); }
+
+inline void installCheckpointSignals() {
+    std::signal(SIGTERM, onCheckpointSignal);
+    std::signal(SIGINT, onCheckpointSignal);
+}
+
+class SnapshotWriter {
+public:
+    explicit SnapshotWriter(std::ostream& out) : out_(out) {}
+
+    template <class T>
+    void put(const T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "snapshot fields must be plain data");
+        out_.write((const char*)&value, sizeof(T));
+    }
+
+    template <class T>
+    void putArray(const T* data, size_t count) {
+        out_.write((const char*)data, (std::streamsize)(count * sizeof(T)));
+    }
+
+    template <class T>
+    void putVector(const std::vector<T>& values) {
+        put<uint64_t>(values.size());
+        putArray(values.data(), values.size());
+    }
+
+    /**
+     * @brief Board cells without a length; every board of a search has the start's size
+     */
+    template <class Board>
+    void putBoard(const Board& board) {
+        putArray(board.data(), board.size());
+    }
+
+private:
+    std::ostream& out_;
+};
+
+/**
+ * @brief Reads what SnapshotWriter wrote; throws std::runtime_error past the end of the file
+ */
+class SnapshotReader {
+public:
+    SnapshotReader(std::istream& in, uint64_t bytes) : in_(in), left_(bytes) {}
+
+    template <class T>
+    T get() {
+        T value;
+        getArray(&value, 1);
+        return value;
+    }
+
+    template <class T>
+    void getArray(T* data, size_t count) {
+        // Checked against the file size first, so a corrupt count cannot allocate gigabytes.
+        uint64_t bytes = (uint64_t)count * sizeof(T);
+        if (bytes > left_ || !in_.read((char*)data, (std::streamsize)bytes))
+            throw std::runtime_error("instantánea truncada");
+        left_ -= bytes;
+    }
+
+    template <class T>
+    void getVector(std::vector<T>& values) {
+        uint64_t count = get<uint64_t>();
+        if (count > left_ / sizeof(T)) throw std::runtime_error("instantánea truncada");
+        values.resize(count);
+        getArray(values.data(), values.size());
+    }
+
+    template <class Board>
+    void getBoard(Board& board, size_t cells) {
+        board.resize(cells);
+        getArray(&board[0], cells);
+    }
+
+    uint64_t left() const { return left_; }
+
+private:
+    std::istream& in_;
+    uint64_t left_;
+};
+
+/**
+ * @brief The container of a std::queue or std::priority_queue
+ *
+ * Both adaptors keep it in the protected member `c`. The open list is
+ * written straight from it, and a heap is loaded back in the same layout,
+ * so a resumed search pops equal-f nodes in the order the original would.
+ */
+template <class Adaptor>
+typename Adaptor::container_type& adaptorContainer(Adaptor& adaptor) {
+    struct Access : Adaptor {
+        static typename Adaptor::container_type& of(Adaptor& a) { return a.*&Access::c; }
+    };
+    return Access::of(adaptor);
+}
+
+template <class Adaptor>
+const typename Adaptor::container_type& adaptorContainer(const Adaptor& adaptor) {
+    return adaptorContainer(const_cast<Adaptor&>(adaptor));
+}
+
+/**
+ * @brief Snapshot file of one search: when to write it, writing, loading and removing it
+ */
+class SearchCheckpoint {
+public:
+    static const long long CLOCK_STRIDE = 4096;
+
+    /**
+     * @brief `parameters` must cover everything that changes the search besides the start board
+     */
+    template <class Board>
+    SearchCheckpoint(const CheckpointOptions& options, const std::string& engine, const std::string& parameters,
+                     const Board& start)
+        : seconds_(options.seconds), last_(std::chrono::steady_clock::now()) {
+        if (options.directory.empty()) return;
+        identity_ = engine + '\0' + parameters + '\0' +
+                    std::string((const char*)start.data(), start.size() * sizeof(start[0]));
+        uint64_t hash = 14695981039346656037ULL;
+        for (unsigned char byte : identity_) hash = (hash ^ byte) * 1099511628211ULL;
+        char name[17];
+        snprintf(name, sizeof(name), "%016llx", (unsigned long long)hash);
+        mkdir(options.directory.c_str(), 0777);
+        path_ = options.directory + "/" + engine + "-" + name + ".pzck";
+    }
+
+    bool enabled() const { return !path_.empty(); }
+
+    const std::string& path() const { return path_; }
+
+    /**
+     * @brief True when a snapshot should be written now; the clock is read every `stride` calls
+     */
+    bool due(long long stride = CLOCK_STRIDE) {
+        if (path_.empty()) return false;
+        if (checkpointStop.load(std::memory_order_relaxed)) return true;
+        if (++calls_ % stride != 0) return false;
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - last_).count() >= seconds_;
+    }
+
+    /**
+     * @brief True once a signal asked the searches to stop after their snapshot
+     */
+    bool interrupted() const { return !path_.empty() && checkpointStop.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Writes the header and `body(SnapshotWriter&)` to a new snapshot; false (with a warning) on I/O errors
+     */
+    template <class Body>
+    bool save(Body body) {
+        if (path_.empty()) return false;
+        std::string temp = path_ + ".tmp";
+        {
+            std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+            SnapshotWriter writer(out);
+            out.write(CHECKPOINT_MAGIC, 4);
+            writer.put(CHECKPOINT_VERSION);
+            writer.put<uint16_t>(0);
+            writer.put<uint32_t>((uint32_t)identity_.size());
+            writer.putArray(identity_.data(), identity_.size());
+            body(writer);
+            out.flush();
+            if (!out) {
+                std::cerr << "Aviso: no se pudo escribir la instantánea " << temp << std::endl;
+                std::remove(temp.c_str());
+                return false;
+            }
+        }
+        if (std::rename(temp.c_str(), path_.c_str()) != 0) {
+            std::cerr << "Aviso: no se pudo escribir la instantánea " << path_ << std::endl;
+            return false;
+        }
+        last_ = std::chrono::steady_clock::now();
+        return true;
+    }
+
+    /**
+     * @brief Loads an existing snapshot with `body(SnapshotReader&)`
+     *
+     * False when there is none or it cannot be used (a warning is printed);
+     * the caller then starts from scratch and must discard whatever `body`
+     * loaded before it failed.
+     */
+    template <class Body>
+    bool resume(Body body) {
+        if (path_.empty()) return false;
+        std::ifstream in(path_, std::ios::binary | std::ios::ate);
+        if (!in) return false;
+        uint64_t bytes = (uint64_t)in.tellg();
+        in.seekg(0);
+        try {
+            SnapshotReader reader(in, bytes);
+            char magic[4];
+            reader.getArray(magic, 4);
+            if (memcmp(magic, CHECKPOINT_MAGIC, 4) != 0 || reader.get<uint16_t>() != CHECKPOINT_VERSION)
+                throw std::runtime_error("no es una instantánea válida");
+            reader.get<uint16_t>();
+            std::string identity(reader.get<uint32_t>(), '\0');
+            if (identity.size() > reader.left()) throw std::runtime_error("instantánea truncada");
+            reader.getArray(&identity[0], identity.size());
+            if (identity != identity_) throw std::runtime_error("pertenece a otra búsqueda");
+            body(reader);
+            if (reader.left() != 0) throw std::runtime_error("datos sobrantes al final");
+        } catch (const std::exception& e) {
+            std::cerr << "Aviso: se ignora la instantánea " << path_ << ": " << e.what() << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Removes the snapshot of a finished search
+     */
+    void discard() {
+        if (!path_.empty()) std::remove(path_.c_str());
+    }
+
+private:
+    std::string path_;
+    std::string identity_;
+    double seconds_;
+    long long calls_ = 0;
+    std::chrono::steady_clock::time_point last_;
+};
+
+#endif
@@ -0,0 +1,163 @@
+/**
+ * @file thread_placement.h
+ * @brief Pinning of OpenMP worker threads to cores and sockets
+ *
+ * The CPUs the process may run on are read from sched_getaffinity and grouped
+ * by socket (physical_package_id in sysfs). With --bind compact the workers
+ * fill one socket before moving to the next; with --bind spread they are
+ * dealt round-robin over the sockets. --sockets <n> keeps only the first n
+ * sockets. Each worker pins itself at the start of the persistent parallel
+ * region, so everything it allocates afterwards (its node arena) is first
+ * touched, and placed by Linux, on its own NUMA node.
+ *
+ * Sockets are used as NUMA domains, which is what the dual-socket servers
+ * the solvers run on look like. On other systems, or with --bind none (the
+ * default), threads are left where the OpenMP runtime puts them.
+ */
+#ifndef THREAD_PLACEMENT_H
+#define THREAD_PLACEMENT_H
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+enum PlacementPolicy { PLACE_NONE = 0, PLACE_COMPACT, PLACE_SPREAD };
+
+struct PlacementOptions {
+    PlacementPolicy policy = PLACE_NONE;
+    int sockets = 0;  // 0 = every socket
+};
+
+/**
+ * @brief Consumes --bind none|compact|spread and --sockets <n> at argv[i]
+ */
+inline bool parsePlacementOption(int& i, int argc, char* argv[], PlacementOptions& options) {
+    std::string arg = argv[i];
+    if (i + 1 >= argc) return false;
+    std::string value = argv[i + 1];
+    if (arg == "--bind") {
+        if (value == "none") options.policy = PLACE_NONE;
+        else if (value == "compact") options.policy = PLACE_COMPACT;
+        else if (value == "spread") options.policy = PLACE_SPREAD;
+        else return false;
+    } else if (arg == "--sockets") {
+        options.sockets = std::max(0, atoi(value.c_str()));
+    } else {
+        return false;
+    }
+    i++;
+    return true;
+}
+
+class ThreadPlacement {
+public:
+    explicit ThreadPlacement(const PlacementOptions& options) : policy_(options.policy) {
+        if (policy_ == PLACE_NONE) return;
+#ifdef __linux__
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+            policy_ = PLACE_NONE;
+            return;
+        }
+        std::vector<std::vector<int>> bySocket;
+        std::vector<int> socketIds;
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (!CPU_ISSET(cpu, &allowed)) continue;
+            int socket = readSocket(cpu);
+            size_t index = std::find(socketIds.begin(), socketIds.end(), socket) - socketIds.begin();
+            if (index == socketIds.size()) {
+                socketIds.push_back(socket);
+                bySocket.emplace_back();
+            }
+            bySocket[index].push_back(cpu);
+        }
+        // Order sockets by id so "--sockets 1" always means the first package.
+        std::vector<size_t> order(socketIds.size());
+        for (size_t i = 0; i < order.size(); i++) order[i] = i;
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return socketIds[a] < socketIds[b]; });
+        size_t keep = options.sockets > 0 ? std::min(order.size(), (size_t)options.sockets) : order.size();
+        for (size_t i = 0; i < keep; i++) sockets_.push_back(bySocket[order[i]]);
+#endif
+        if (sockets_.empty()) policy_ = PLACE_NONE;
+    }
+
+    bool enabled() const { return policy_ != PLACE_NONE; }
+
+    int socketCount() const { return (int)sockets_.size(); }
+
+    /**
+     * @brief CPUs available after the socket filter
+     */
+    int cpuCount() const {
+        int count = 0;
+        for (const auto& socket : sockets_) count += (int)socket.size();
+        return count;
+    }
+
+    /**
+     * @brief Socket index (0-based, after filtering) of worker `thread`
+     */
+    int socketOf(int thread) const {
+        if (!enabled()) return 0;
+        if (policy_ == PLACE_SPREAD) return thread % socketCount();
+        int slot = thread % cpuCount();
+        int socket = 0;
+        while (slot >= (int)sockets_[socket].size()) slot -= (int)sockets_[socket++].size();
+        return socket;
+    }
+
+    /**
+     * @brief CPU of worker `thread`; threads beyond the CPU count wrap around
+     */
+    int cpuOf(int thread) const {
+        if (!enabled()) return -1;
+        if (policy_ == PLACE_SPREAD) {
+            const std::vector<int>& socket = sockets_[thread % socketCount()];
+            return socket[(thread / socketCount()) % socket.size()];
+        }
+        int slot = thread % cpuCount();
+        int socket = 0;
+        while (slot >= (int)sockets_[socket].size()) slot -= (int)sockets_[socket++].size();
+        return sockets_[socket][slot];
+    }
+
+    /**
+     * @brief Pins the calling thread as worker `thread`; call from inside the parallel region
+     */
+    void pin(int thread) const {
+#ifdef __linux__
+        if (!enabled()) return;
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpuOf(thread), &set);
+        sched_setaffinity(0, sizeof(set), &set);
+#else
+        (void)thread;
+#endif
+    }
+
+    std::string describe() const {
+        if (!enabled()) return "sin fijar";
+        return std::string(policy_ == PLACE_COMPACT ? "compact" : "spread") + ", " +
+               std::to_string(socketCount()) + " socket(s), " + std::to_string(cpuCount()) + " CPU(s)";
+    }
+
+private:
+    static int readSocket(int cpu) {
+        std::ifstream in("/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/physical_package_id");
+        int socket = 0;
+        if (!(in >> socket)) socket = 0;
+        return socket;
+    }
+
+    PlacementPolicy policy_;
+    std::vector<std::vector<int>> sockets_;
+};
+
+#endif